@@ -0,0 +1,50 @@
+#!/bin/bash
+# Run the miner over a matrix of synthetic datasets, thresholds and thread counts, and append
+# one CSV row per run to $BENCH_OUT (bench/results.csv), so that builds can be compared.
+#
+#   $ make bench
+#   $ THREADS="1 2 4 8" bench/bench.sh
+#
+# Datasets are generated into bench/data on the first run, always from the same seed.
+set -e
+cd "$(dirname "$0")/.."
+OUT=${BENCH_OUT:-bench/results.csv}
+DATA=bench/data
+THREADS=${THREADS:-$(echo 1 $(nproc) | tr ' ' '\n' | sort -nu | tr '\n' ' ')}
+BUILD=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+
+# name: generator options
+DATASETS=(
+    "uniform: --sequences 2000 --length 8 --itemset 3 --items 200 --zipf 0"
+    "zipf: --sequences 5000 --length 8 --itemset 3 --items 500 --zipf 1.2 --utility lognormal --max-utility 50"
+    "long: --sequences 300 --length 25 --itemset 2 --items 300 --zipf 0.8 --utility exponential --max-utility 50"
+)
+# dataset MIN_SUPP MIN_UTIL
+RUNS=(
+    "uniform 20 200"
+    "uniform 10 150"
+    "zipf 400 2500"
+    "zipf 250 2000"
+    "long 30 800"
+    "long 20 600"
+)
+
+mkdir -p $DATA
+for dataset in "${DATASETS[@]}"; do
+    name=${dataset%%:*}
+    [ -f $DATA/$name/sequences.csv ] || ./generate $DATA/$name ${dataset#*:} > /dev/null
+done
+
+[ -f "$OUT" ] || echo "build,dataset,min_supp,min_util,threads,seconds,search_seconds,peak_rss_kb,patterns" > "$OUT"
+for run in "${RUNS[@]}"; do
+    set -- $run
+    for threads in $THREADS; do
+        start=$(date +%s.%N)
+        patterns=$(./exe $2 $3 $DATA/$1 --threads $threads --stats 2> $DATA/stats.json | tail -1 | cut -d' ' -f2)
+        end=$(date +%s.%N)
+        search=$(sed -n 's/.*"search": \([0-9.e+-]*\).*/\1/p' $DATA/stats.json)
+        rss=$(sed -n 's/.*"peak_rss_kb": \([0-9]*\).*/\1/p' $DATA/stats.json)
+        row=$(awk "BEGIN { printf \"%s,%s,%s,%s,%d,%.3f,%.3f,%d,%d\", \"$BUILD\", \"$1\", $2, $3, $threads, $end - $start, $search, $rss, $patterns }")
+        echo "$row" | tee -a "$OUT"
+    done
+done
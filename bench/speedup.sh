@@ -0,0 +1,24 @@
+#!/bin/bash
+# Speedup curve of the miner over 1..MAX_THREADS threads, written as CSV to stdout.
+#
+#   $ bench/speedup.sh MIN_SUPP MIN_UTIL INPUT_DATA_PATH [MAX_THREADS] [OPTIONS...]
+#
+# MAX_THREADS defaults to the number of cores, OPTIONS are passed on to every run.
+set -e
+if [ $# -lt 3 ]; then
+    sed -n '2,6p' "$0" >&2
+    exit 1
+fi
+EXE=${EXE:-./exe}
+MIN_SUPP=$1; MIN_UTIL=$2; DATA=$3; shift 3
+MAX_THREADS=${1:-$(nproc)}; [ $# -gt 0 ] && shift
+
+echo "threads,seconds,speedup"
+for ((threads = 1; threads <= MAX_THREADS; ++threads)); do
+    start=$(date +%s.%N)
+    "$EXE" "$MIN_SUPP" "$MIN_UTIL" "$DATA" --threads $threads "$@" > /dev/null
+    end=$(date +%s.%N)
+    seconds=$(awk "BEGIN { print $end - $start }")
+    [ $threads -eq 1 ] && base=$seconds
+    awk "BEGIN { printf \"%d,%.3f,%.2f\\n\", $threads, $seconds, $base / $seconds }"
+done
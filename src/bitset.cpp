@@ -0,0 +1,62 @@
+#include "bitset.h"
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX2__) && !(defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__))
+/*
+    Bytewise population count through a nibble lookup table, summed into 64-bit lanes
+*/
+static inline __m256i popcount256(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+    );
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i counts = _mm256_add_epi8(
+        _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+        _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low))
+    );
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+#endif
+
+unsigned int popcountAnd(const uint64_t *a, const uint64_t *b, size_t length) {
+    size_t word = 0;
+    uint64_t count = 0;
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+    __m512i sum = _mm512_setzero_si512();
+    for (; word + 8 <= length; word += 8) {
+        __m512i v = _mm512_and_si512(_mm512_loadu_si512(a + word), _mm512_loadu_si512(b + word));
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(v));
+    }
+    count += _mm512_reduce_add_epi64(sum);
+#elif defined(__AVX2__)
+    __m256i sum = _mm256_setzero_si256();
+    for (; word + 4 <= length; word += 4) {
+        __m256i v = _mm256_and_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + word)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + word))
+        );
+        sum = _mm256_add_epi64(sum, popcount256(v));
+    }
+    count += _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) +
+        _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3);
+#endif
+    for (; word < length; ++word) count += __builtin_popcountll(a[word] & b[word]);
+    return count;
+}
+
+long firstCommonBit(const uint64_t *a, const uint64_t *b, size_t length) {
+    size_t word = 0;
+#if defined(__AVX2__)
+    for (; word + 4 <= length; word += 4) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + word));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + word));
+        if (!_mm256_testz_si256(va, vb)) break;
+    }
+#endif
+    for (; word < length; ++word)
+        if (a[word] & b[word]) return word * WORD_BITS + __builtin_ctzll(a[word] & b[word]);
+    return -1;
+}
@@ -0,0 +1,20 @@
+/*
+    Word-wise kernels over bitmaps of 64-bit words. The vector paths are picked at compile time
+    from the target (-march=native), with a portable scalar fallback.
+*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+const unsigned int WORD_BITS = 64;
+
+inline unsigned int numWords(unsigned int bits) { return (bits + WORD_BITS - 1) / WORD_BITS; }
+
+/*
+    Number of bits set in both a and b
+*/
+unsigned int popcountAnd(const uint64_t *a, const uint64_t *b, size_t length);
+/*
+    Index of the first bit set in both a and b, or -1 when they have none in common
+*/
+long firstCommonBit(const uint64_t *a, const uint64_t *b, size_t length);
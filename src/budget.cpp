@@ -0,0 +1,41 @@
+#include "budget.h"
+
+/*
+    Share of the limit past which subtrees run inline
+*/
+const double SPAWN_SHARE = 0.9;
+
+MemoryBudget::MemoryBudget(size_t limit) : bytesLimit(limit), bytes(0), peakBytes(0) {}
+
+size_t MemoryBudget::limit() const {
+    return this->bytesLimit;
+}
+
+size_t MemoryBudget::used() const {
+    return this->bytes.load(std::memory_order_relaxed);
+}
+
+size_t MemoryBudget::peak() const {
+    return this->peakBytes.load(std::memory_order_relaxed);
+}
+
+bool MemoryBudget::isNearLimit() const {
+    return this->used() >= this->bytesLimit * SPAWN_SHARE;
+}
+
+void* MemoryBudget::do_allocate(size_t bytes, size_t alignment) {
+    void *p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    const size_t used = this->bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = this->peakBytes.load(std::memory_order_relaxed);
+    while (used > peak && !this->peakBytes.compare_exchange_weak(peak, used, std::memory_order_relaxed));
+    return p;
+}
+
+void MemoryBudget::do_deallocate(void *p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    this->bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool MemoryBudget::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,41 @@
+/*
+    Memory held by the search, for bounding its frontier.
+
+    Every search node allocates its pattern's SIDUL and bitmaps from an arena of its own, whose
+    blocks come from a MemoryBudget when a limit is set. The budget counts the bytes handed out
+    and not yet returned, i.e. the nodes currently running or suspended in a taskwait, but not
+    the subtrees waiting as tasks, which are only built once they run. Once the count nears the
+    limit, no subtree is left waiting as a task any more: they run inline, one after the other,
+    and the memory of the search stops growing with the width of the frontier.
+
+    The context and the closed set are not counted.
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+class MemoryBudget : public std::pmr::memory_resource {
+    public:
+        MemoryBudget(size_t limit);
+        size_t limit() const;
+        size_t used() const;
+        /*
+            Highest count of bytes in use over the run
+        */
+        size_t peak() const;
+        /*
+            Whether the bytes in use reached the share of the limit past which no more subtrees
+            are spawned, the rest being left to the nodes already running
+        */
+        bool isNearLimit() const;
+
+    private:
+        size_t bytesLimit;
+        std::atomic<size_t> bytes;
+        std::atomic<size_t> peakBytes;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+};
@@ -0,0 +1,216 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "checkpoint.h"
+
+template <typename T>
+static void writeValue(std::ofstream &file, const T &value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename Vector>
+static void writeVector(std::ofstream &file, const Vector &values) {
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+}
+
+template <typename T>
+static T readValue(std::ifstream &file) {
+    T value;
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+template <typename Vector>
+static void readVector(std::ifstream &file, Vector &values, size_t size) {
+    values.resize(size);
+    file.read(reinterpret_cast<char*>(values.data()), size * sizeof(values[0]));
+}
+
+template <typename Utility>
+bool readCheckpoint(const CheckpointRun &run, Checkpoint<Utility> &checkpoint) {
+    std::ifstream file(run.path, std::ios::binary);
+    if (!file) return false;
+    const CheckpointHeader header = readValue<CheckpointHeader>(file);
+    if (
+        !file ||
+        std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+        header.version != CHECKPOINT_VERSION
+    ) throw std::runtime_error(run.path + " is not a supported checkpoint");
+    std::vector<float> thresholds;
+    readVector(file, thresholds, header.numThresholds);
+    if (
+        header.hash != run.hash ||
+        header.utilityType != static_cast<uint32_t>(run.utility.type) ||
+        header.utilityScale != run.utility.scale ||
+        header.topK != run.topK ||
+        header.partitionIndex != run.partition.index ||
+        header.partitionCount != run.partition.count ||
+        thresholds != run.thresholds
+    ) throw std::runtime_error(run.path + " is the checkpoint of another search");
+
+    readVector(file, checkpoint.roots, header.numRoots);
+    checkpoint.stores.resize(header.numStores);
+    for (auto &store : checkpoint.stores) {
+        store.resize(readValue<uint64_t>(file));
+        for (auto &stored : store) {
+            const uint32_t length = readValue<uint32_t>(file);
+            stored.pattern.size = readValue<uint32_t>(file);
+            stored.pattern.support = readValue<uint32_t>(file);
+            stored.pattern.SE = readValue<uint32_t>(file);
+            stored.pattern.SLIP = readValue<uint32_t>(file);
+            stored.key = readValue<uint64_t>(file);
+            stored.pattern.umin = readValue<Utility>(file);
+            readVector(file, stored.pattern.items, length);
+            if (!file) break;
+        }
+        if (!file) break;
+    }
+    if (!file) throw std::runtime_error(run.path + " is truncated");
+    return true;
+}
+
+template <typename Utility>
+void writeCheckpoint(const CheckpointRun &run, const Checkpoint<Utility> &checkpoint) {
+    const std::string partialPath = run.path + ".partial";
+    std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("cannot write " + partialPath);
+
+    CheckpointHeader header;
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.utilityType = static_cast<uint32_t>(run.utility.type);
+    header.hash = run.hash;
+    header.utilityScale = run.utility.scale;
+    header.topK = run.topK;
+    header.partitionIndex = run.partition.index;
+    header.partitionCount = run.partition.count;
+    header.numThresholds = run.thresholds.size();
+    header.numRoots = checkpoint.roots.size();
+    header.numStores = checkpoint.stores.size();
+    header.reserved = 0;
+    writeValue(file, header);
+    writeVector(file, run.thresholds);
+    writeVector(file, checkpoint.roots);
+    for (auto &store : checkpoint.stores) {
+        writeValue<uint64_t>(file, store.size());
+        for (auto &stored : store) {
+            writeValue<uint32_t>(file, stored.pattern.items.size());
+            writeValue<uint32_t>(file, stored.pattern.size);
+            writeValue<uint32_t>(file, stored.pattern.support);
+            writeValue<uint32_t>(file, stored.pattern.SE);
+            writeValue<uint32_t>(file, stored.pattern.SLIP);
+            writeValue<uint64_t>(file, stored.key);
+            writeValue<Utility>(file, stored.pattern.umin);
+            writeVector(file, stored.pattern.items);
+        }
+    }
+    file.close();
+    if (!file || std::rename(partialPath.c_str(), run.path.c_str()) != 0) throw std::runtime_error("cannot write " + run.path);
+}
+
+template <typename Utility>
+CheckpointWriter<Utility>::CheckpointWriter(const CheckpointRun &run, const std::vector<int> &rootIds, const std::vector<FCloStore<Utility>*> &stores) :
+    run(run), rootIds(rootIds), stores(stores), over(new std::atomic<bool>[rootIds.size()]) {
+    for (unsigned int root = 0; root < rootIds.size(); ++root) {
+        this->roots[rootIds[root]] = root;
+        this->over[root].store(false, std::memory_order_relaxed);
+    }
+}
+
+template <typename Utility>
+CheckpointWriter<Utility>::~CheckpointWriter() {
+    if (!this->thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->isStopped = true;
+    }
+    this->stopped.notify_one();
+    this->thread.join();
+}
+
+template <typename Utility>
+unsigned int CheckpointWriter<Utility>::resume() {
+    Checkpoint<Utility> checkpoint;
+    if (!readCheckpoint(this->run, checkpoint)) return 0;
+    if (checkpoint.stores.size() != this->stores.size()) throw std::runtime_error(this->run.path + " is the checkpoint of another search");
+    for (auto id : checkpoint.roots) {
+        auto root = this->roots.find(id);
+        if (root == this->roots.end()) throw std::runtime_error(this->run.path + " is the checkpoint of another search");
+        this->over[root->second].store(true, std::memory_order_relaxed);
+    }
+    for (size_t idx = 0; idx < this->stores.size(); ++idx)
+        for (auto &stored : checkpoint.stores[idx]) this->stores[idx]->restore(stored);
+    return checkpoint.roots.size();
+}
+
+template <typename Utility>
+void CheckpointWriter<Utility>::start() {
+    this->thread = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (!this->stopped.wait_for(lock, std::chrono::seconds(this->run.interval), [this]() { return this->isStopped; })) {
+            lock.unlock();
+            this->write();
+            lock.lock();
+        }
+    });
+}
+
+template <typename Utility>
+bool CheckpointWriter<Utility>::isOver(unsigned int root) const {
+    return this->over[root].load(std::memory_order_acquire);
+}
+
+template <typename Utility>
+void CheckpointWriter<Utility>::finish(unsigned int root) {
+    this->over[root].store(true, std::memory_order_release);
+}
+
+template <typename Utility>
+unsigned int CheckpointWriter<Utility>::stop() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->isStopped = true;
+    }
+    this->stopped.notify_one();
+    if (this->thread.joinable()) this->thread.join();
+    this->write();
+    return this->written;
+}
+
+/*
+    The roots over are read before the closed sets are copied, so every pattern of theirs has
+    been stored by then. A failed checkpoint is reported and the search goes on, the previous
+    one being left in place.
+*/
+template <typename Utility>
+void CheckpointWriter<Utility>::write() {
+    Checkpoint<Utility> checkpoint;
+    std::vector<char> isOver(this->rootIds.size(), false);
+    for (unsigned int root = 0; root < this->rootIds.size(); ++root) {
+        if (!this->isOver(root)) continue;
+        isOver[root] = true;
+        checkpoint.roots.push_back(this->rootIds[root]);
+    }
+    for (auto store : this->stores)
+        checkpoint.stores.push_back(store->copy([&](const BasicFCloPattern<Utility> &pattern) {
+            return isOver[this->roots.at(pattern.items.front())];
+        }));
+    try {
+        writeCheckpoint(this->run, checkpoint);
+        ++this->written;
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+    }
+}
+
+#define INSTANTIATE(Utility) \
+    template bool readCheckpoint(const CheckpointRun &run, Checkpoint<Utility> &checkpoint); \
+    template void writeCheckpoint(const CheckpointRun &run, const Checkpoint<Utility> &checkpoint); \
+    template class CheckpointWriter<Utility>;
+INSTANTIATE(float)
+INSTANTIATE(int32_t)
+INSTANTIATE(int64_t)
+#undef INSTANTIATE
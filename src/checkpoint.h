@@ -0,0 +1,135 @@
+/*
+    Checkpoints of a long search, from which a run stopped midway is resumed.
+
+    A pattern is only ever found in the subtree of its first item. Once the subtree of such a
+    root is over, the closed patterns found in it are final, but for the ones patterns of other
+    subtrees subsume, which the resumed search finds again. A checkpoint keeps the roots whose
+    subtrees are over and the patterns of those roots in each closed set of the run. Patterns
+    of subtrees still running are left out: the resumed search runs them again from their root,
+    and a stored pattern it met again would prune the subtree below it.
+
+    Checkpoints are copied and written by a thread of their own every few minutes, the search
+    threads only ever waiting for it on the lock of a stripe of a closed set while it is copied.
+    A checkpoint is written next to its path and renamed over it once complete, so that a run
+    stopped while writing one leaves the previous one. All fields are in native byte order:
+
+        CheckpointHeader
+        float    thresholds[numThresholds]      MIN_SUPP and MIN_UTIL of each setting of the run
+        int32_t  roots[numRoots]                ids of the items whose subtrees are over
+        numStores times, a closed set:
+            uint64_t numPatterns
+            numPatterns times:
+                uint32_t length, size, support, SE, SLIP
+                uint64_t key                    hash of the sequences of the pattern (see store.h)
+                Utility  umin                   in the units of the search
+                int32_t  items[length]
+
+    Item ids are those of the search, which only depend on the input and the thresholds.
+*/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "fixed.h"
+#include "partition.h"
+#include "store.h"
+
+const char CHECKPOINT_MAGIC[8] = {'P', 'F', 'C', 'H', 'U', 'S', 'C', 'P'};
+const uint32_t CHECKPOINT_VERSION = 1;
+/*
+    Seconds between two checkpoints by default
+*/
+const unsigned int CHECKPOINT_INTERVAL = 300;
+
+class CheckpointHeader {
+    public:
+        char magic[8];
+        uint32_t version;
+        uint32_t utilityType;
+        uint64_t hash;
+        double utilityScale;
+        uint32_t topK;
+        uint32_t partitionIndex;
+        uint32_t partitionCount;
+        uint32_t numThresholds;
+        uint64_t numRoots;
+        uint32_t numStores;
+        uint32_t reserved;
+};
+
+/*
+    The search a checkpoint belongs to, which a run resuming it must repeat: the hash of the
+    input, the thresholds of its settings and the options that change the closed sets
+*/
+class CheckpointRun {
+    public:
+        std::string path;
+        unsigned int interval = CHECKPOINT_INTERVAL;
+        bool isResumed = false;
+        uint64_t hash = 0;
+        std::vector<float> thresholds;
+        UtilityScale utility;
+        unsigned int topK = 0;
+        Partition partition;
+};
+
+template <typename Utility>
+class Checkpoint {
+    public:
+        std::vector<int> roots;
+        std::vector<std::vector<StoredPattern<Utility>>> stores;
+};
+
+/*
+    False when there is no checkpoint at path yet. A checkpoint of another search is an error.
+*/
+template <typename Utility>
+bool readCheckpoint(const CheckpointRun &run, Checkpoint<Utility> &checkpoint);
+template <typename Utility>
+void writeCheckpoint(const CheckpointRun &run, const Checkpoint<Utility> &checkpoint);
+
+/*
+    Keeps track of the roots of a search over the closed sets given, the first of which is the
+    one searched, and writes its checkpoints from a thread of its own until stopped. Roots are
+    numbered by their index in the context, their ids being given in rootIds.
+*/
+template <typename Utility>
+class CheckpointWriter {
+    public:
+        CheckpointWriter(const CheckpointRun &run, const std::vector<int> &rootIds, const std::vector<FCloStore<Utility>*> &stores);
+        ~CheckpointWriter();
+        /*
+            Restore the closed sets and the roots over of the checkpoint at the path of the run,
+            if there is one, and return the number of those roots. Only before start.
+        */
+        unsigned int resume();
+        void start();
+        bool isOver(unsigned int root) const;
+        /*
+            Called once the whole subtree of the root is over
+        */
+        void finish(unsigned int root);
+        /*
+            Stop the thread and write a last checkpoint, return the number of checkpoints written
+        */
+        unsigned int stop();
+
+    private:
+        CheckpointRun run;
+        std::vector<int> rootIds;
+        std::unordered_map<int, unsigned int> roots;
+        std::vector<FCloStore<Utility>*> stores;
+        std::unique_ptr<std::atomic<bool>[]> over;
+        unsigned int written = 0;
+        bool isStopped = false;
+        std::mutex mutex;
+        std::condition_variable stopped;
+        std::thread thread;
+
+        void write();
+};
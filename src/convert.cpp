@@ -0,0 +1,22 @@
+/*
+    Convert a dataset in the two-file CSV layout into the binary layout read by the miner.
+
+        $ convert INPUT_DATA_PATH OUTPUT_FILE
+*/
+#include "utils.h"
+
+int main(int argvc, char** argv) {
+    if (argvc != 3) {
+        std::cerr << "Usage: " << argv[0] << " INPUT_DATA_PATH OUTPUT_FILE" << std::endl;
+        return 1;
+    }
+
+    Database database = readInputData(argv[1]);
+    writeBinaryData(database, argv[2]);
+
+    size_t numRecords = 0;
+    for (auto &sequence : database.sequences) numRecords += sequence.length;
+    std::cout << "# sequences: " << database.sequences.size() << ", # records: " << numRecords << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,315 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cmath>
+#include <algorithm>
+#include "omp.h"
+#include "dataset.h"
+#include "utils.h"
+
+std::shared_ptr<void> mapFile(const std::string &path, size_t &length) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("cannot open " + path);
+    struct stat status;
+    fstat(fd, &status);
+    length = status.st_size;
+    if (!length) {
+        close(fd);
+        return nullptr;
+    }
+    void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) throw std::runtime_error("cannot map " + path);
+    const size_t mappedLength = length;
+    return std::shared_ptr<void>(address, [mappedLength](void *address) { munmap(address, mappedLength); });
+}
+
+bool isBinaryData(const std::string &path) {
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode)) return false;
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(BINARY_MAGIC)];
+    if (!file.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+Database readBinaryData(const std::string &path) {
+    size_t length;
+    Database database;
+    database.mapping = mapFile(path, length);
+    if (!database.mapping) throw std::runtime_error(path + " is empty");
+    void *address = database.mapping.get();
+
+    const char *data = static_cast<const char*>(address);
+    const BinaryHeader *header = reinterpret_cast<const BinaryHeader*>(data);
+    if (
+        length < sizeof(BinaryHeader) ||
+        std::memcmp(header->magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 ||
+        header->version != BINARY_VERSION ||
+        header->recordSize != sizeof(Item)
+    ) throw std::runtime_error(path + " is not a supported binary dataset");
+
+    const size_t numSequences = header->numSequences;
+    const uint64_t *offsets = reinterpret_cast<const uint64_t*>(data + sizeof(BinaryHeader));
+    const float *utilities = reinterpret_cast<const float*>(offsets + numSequences + 1);
+    const uint32_t *sizes = reinterpret_cast<const uint32_t*>(utilities + numSequences);
+    const Item *records = reinterpret_cast<const Item*>(sizes + numSequences);
+    if (reinterpret_cast<const char*>(records + header->numRecords) > data + length)
+        throw std::runtime_error(path + " is truncated");
+
+    /*
+        Sequences are read in order, let the kernel prefetch ahead of us.
+    */
+    madvise(address, length, MADV_SEQUENTIAL);
+
+    database.sequences.resize(numSequences);
+    for (size_t seqID = 0; seqID < numSequences; ++seqID) {
+        Sequence &sequence = database.sequences[seqID];
+        sequence.items = records + offsets[seqID];
+        sequence.length = offsets[seqID + 1] - offsets[seqID];
+        sequence.utility = utilities[seqID];
+        sequence.size = sizes[seqID];
+    }
+
+    return database;
+}
+
+void writeBinaryData(const Database &database, const std::string &path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("cannot write " + path);
+
+    BinaryHeader header;
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.recordSize = sizeof(Item);
+    header.numSequences = database.sequences.size();
+    header.numRecords = 0;
+    for (auto &sequence : database.sequences) header.numRecords += sequence.length;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t offset = 0;
+    for (auto &sequence : database.sequences) {
+        file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        offset += sequence.length;
+    }
+    file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    for (auto &sequence : database.sequences) file.write(reinterpret_cast<const char*>(&sequence.utility), sizeof(float));
+    for (auto &sequence : database.sequences) {
+        const uint32_t size = sequence.size;
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    for (auto &sequence : database.sequences)
+        file.write(reinterpret_cast<const char*>(sequence.items), sequence.length * sizeof(Item));
+    if (!file) throw std::runtime_error("cannot write " + path);
+}
+
+/*
+    Lines of sequences.csv parsed by one thread, together with the matching lines of utilities.csv
+*/
+class CSVChunk {
+    public:
+        const char *sequencesBegin;
+        const char *sequencesEnd;
+        const char *utilitiesBegin;
+        unsigned int firstSeqID;
+        std::vector<Item> records;
+        std::vector<Sequence> sequences;
+        std::unordered_map<unsigned int, std::shared_ptr<Pattern>> sidulItems;
+};
+
+static inline bool isSeparator(char c) {
+    return c == '\t' || c == ' ' || c == '\r';
+}
+
+static int parseInt(const char *&cursor, const char *end) {
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) negative = *cursor++ == '-';
+    int value = 0;
+    while (cursor < end && *cursor >= '0' && *cursor <= '9') value = value * 10 + (*cursor++ - '0');
+    return negative ? -value : value;
+}
+
+/*
+    Digits are accumulated into an integer mantissa with a decimal exponent, so integral
+    utilities are exact and fractional ones are rounded once.
+*/
+static float parseFloat(const char *&cursor, const char *end) {
+    const uint64_t MAX_MANTISSA = 100000000000000000ULL;
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) negative = *cursor++ == '-';
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    for (; cursor < end && *cursor >= '0' && *cursor <= '9'; ++cursor) {
+        if (mantissa < MAX_MANTISSA) mantissa = mantissa * 10 + (*cursor - '0');
+        else ++exponent;
+    }
+    if (cursor < end && *cursor == '.') {
+        for (++cursor; cursor < end && *cursor >= '0' && *cursor <= '9'; ++cursor) {
+            if (mantissa < MAX_MANTISSA) {
+                mantissa = mantissa * 10 + (*cursor - '0');
+                --exponent;
+            }
+        }
+    }
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E')) exponent += parseInt(++cursor, end);
+    double value = mantissa;
+    if (exponent > 0) value *= std::pow(10.0, exponent);
+    else if (exponent < 0) value /= std::pow(10.0, -exponent);
+    return negative ? -value : value;
+}
+
+static size_t countLines(const char *begin, const char *end) {
+    size_t lines = 0;
+    while (begin < end && (begin = static_cast<const char*>(std::memchr(begin, '\n', end - begin)))) {
+        ++lines;
+        ++begin;
+    }
+    return lines;
+}
+
+/*
+    Position right after the given number of line breaks from begin, or end when there are fewer.
+*/
+static const char* findLine(const char *begin, const char *end, size_t line) {
+    for (; line && begin < end; --line) {
+        begin = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        if (!begin) return end;
+        ++begin;
+    }
+    return begin;
+}
+
+static void parseChunk(CSVChunk &chunk, const char *utilitiesEnd, bool withSiduls) {
+    const char *sequencesCursor = chunk.sequencesBegin, *utilitiesCursor = chunk.utilitiesBegin;
+    unsigned int seqID = chunk.firstSeqID;
+    while (sequencesCursor < chunk.sequencesEnd) {
+        Sequence sequence;
+        const size_t firstRecord = chunk.records.size();
+        while (true) {
+            while (sequencesCursor < chunk.sequencesEnd && isSeparator(*sequencesCursor)) ++sequencesCursor;
+            if (sequencesCursor == chunk.sequencesEnd || *sequencesCursor == '\n') break;
+            const char *token = sequencesCursor;
+            int item = parseInt(sequencesCursor, chunk.sequencesEnd);
+            if (sequencesCursor == token) {
+                ++sequencesCursor;
+                continue;
+            }
+            if (item == END_ITEMSET || item == END_SEQUENCE) ++sequence.size;
+            chunk.records.push_back(Item{item, 0});
+        }
+        if (sequencesCursor < chunk.sequencesEnd) ++sequencesCursor;
+        sequence.length = chunk.records.size() - firstRecord;
+
+        size_t record = firstRecord;
+        while (true) {
+            while (utilitiesCursor < utilitiesEnd && isSeparator(*utilitiesCursor)) ++utilitiesCursor;
+            if (utilitiesCursor == utilitiesEnd || *utilitiesCursor == '\n') break;
+            const char *token = utilitiesCursor;
+            float itemUtility = parseFloat(utilitiesCursor, utilitiesEnd);
+            if (utilitiesCursor == token) {
+                ++utilitiesCursor;
+                continue;
+            }
+            if (record < chunk.records.size()) chunk.records[record].utility = itemUtility;
+            sequence.utility += itemUtility;
+            ++record;
+        }
+        if (utilitiesCursor < utilitiesEnd) ++utilitiesCursor;
+
+        /*
+            The sequence is indexed while its records are still hot in cache. The view is only
+            valid until the next sequence is parsed, the database is linked again after merging.
+        */
+        if (withSiduls) {
+            sequence.items = chunk.records.data() + firstRecord;
+            construct_siduls(chunk.sidulItems, seqID, sequence);
+        }
+        chunk.sequences.push_back(sequence);
+        ++seqID;
+    }
+}
+
+Database readCSVData(const std::string &inputDataPath, std::unordered_map<unsigned int, std::shared_ptr<Pattern>> *sidulItems) {
+    size_t sequencesLength, utilitiesLength;
+    std::shared_ptr<void> sequencesFile = mapFile(inputDataPath + "/" + SEQUENCES_FILE, sequencesLength);
+    std::shared_ptr<void> utilitiesFile = mapFile(inputDataPath + "/" + UTILITIES_FILE, utilitiesLength);
+    const char *sequencesData = static_cast<const char*>(sequencesFile.get());
+    const char *utilitiesData = static_cast<const char*>(utilitiesFile.get());
+    const char *sequencesEnd = sequencesData + sequencesLength, *utilitiesEnd = utilitiesData + utilitiesLength;
+    if (!sequencesLength) return Database();
+
+    /*
+        A few chunks per thread so that uneven lines still balance out, and a single one for a
+        single thread, which would only have to join the SIDULs of its chunks again.
+    */
+    const size_t MIN_CHUNK_LENGTH = 1 << 16;
+    const unsigned int threads = omp_get_max_threads();
+    const size_t numChunks = threads < 2 ? 1 : std::max<size_t>(1, std::min<size_t>(threads * 4, sequencesLength / MIN_CHUNK_LENGTH));
+    std::vector<CSVChunk> chunks(numChunks);
+    /*
+        Chunks of sequences.csv start at the first line starting at or after their nominal
+        offset. Chunks of utilities.csv are only used to count lines and may split them.
+    */
+    std::vector<const char*> sequencesBounds(numChunks + 1), utilitiesBounds(numChunks + 1);
+    for (size_t c = 0; c <= numChunks; ++c) {
+        const char *nominal = sequencesData + sequencesLength * c / numChunks;
+        sequencesBounds[c] = c && c < numChunks ? std::max(findLine(nominal - 1, sequencesEnd, 1), sequencesBounds[c - 1]) : nominal;
+        utilitiesBounds[c] = utilitiesData + utilitiesLength * c / numChunks;
+    }
+    std::vector<size_t> sequencesLines(numChunks), utilitiesLines(numChunks);
+    #pragma omp parallel for schedule(static)
+    for (size_t c = 0; c < numChunks; ++c) {
+        sequencesLines[c] = countLines(sequencesBounds[c], sequencesBounds[c + 1]);
+        utilitiesLines[c] = countLines(utilitiesBounds[c], utilitiesBounds[c + 1]);
+    }
+    /*
+        Line l of sequences.csv goes with line l of utilities.csv, which starts right after
+        the l-th line break. Only the utilities chunk holding that line break is scanned.
+    */
+    size_t firstSeqID = 0, utilitiesChunk = 0, utilitiesLinesBefore = 0;
+    for (size_t c = 0; c < numChunks; ++c) {
+        chunks[c].sequencesBegin = sequencesBounds[c];
+        chunks[c].sequencesEnd = sequencesBounds[c + 1];
+        chunks[c].firstSeqID = firstSeqID;
+        while (utilitiesChunk + 1 < numChunks && utilitiesLinesBefore + utilitiesLines[utilitiesChunk] < firstSeqID)
+            utilitiesLinesBefore += utilitiesLines[utilitiesChunk++];
+        chunks[c].utilitiesBegin = firstSeqID ?
+            findLine(utilitiesBounds[utilitiesChunk], utilitiesEnd, firstSeqID - utilitiesLinesBefore) :
+            utilitiesData;
+        firstSeqID += sequencesLines[c];
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t c = 0; c < numChunks; ++c) parseChunk(chunks[c], utilitiesEnd, sidulItems != nullptr);
+    sequencesFile.reset();
+    utilitiesFile.reset();
+
+    Database database;
+    std::vector<size_t> firstRecords(numChunks + 1, 0);
+    for (size_t c = 0; c < numChunks; ++c) {
+        firstRecords[c + 1] = firstRecords[c] + chunks[c].records.size();
+        database.sequences.insert(database.sequences.end(), chunks[c].sequences.begin(), chunks[c].sequences.end());
+    }
+    if (numChunks == 1) database.records = std::move(chunks[0].records);
+    else {
+        database.records.resize(firstRecords[numChunks]);
+        #pragma omp parallel for schedule(static)
+        for (size_t c = 0; c < numChunks; ++c) {
+            std::copy(chunks[c].records.begin(), chunks[c].records.end(), database.records.begin() + firstRecords[c]);
+            std::vector<Item>().swap(chunks[c].records);
+        }
+    }
+    database.link(database.records.data());
+
+    if (sidulItems) {
+        std::vector<std::unordered_map<unsigned int, std::shared_ptr<Pattern>>> fragments(numChunks);
+        for (size_t c = 0; c < numChunks; ++c) fragments[c] = std::move(chunks[c].sidulItems);
+        join_siduls(*sidulItems, fragments, database);
+    }
+
+    return database;
+}
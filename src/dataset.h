@@ -0,0 +1,42 @@
+/*
+    Binary dataset layout, all fields in native byte order:
+
+        BinaryHeader
+        uint64_t offsets[numSequences + 1]   index of the first record of each sequence
+        float    utilities[numSequences]     sequence utilities
+        uint32_t sizes[numSequences]         number of itemsets of each sequence
+        Item     records[numRecords]         items and their utilities interleaved
+
+    The records keep END_ITEMSET/END_SEQUENCE exactly like the CSV tokens, so once the file
+    is mapped the sequences of a Database point straight into it without copying.
+*/
+#pragma once
+#include <string>
+#include <unordered_map>
+#include "models.h"
+
+const char BINARY_MAGIC[8] = {'P', 'F', 'C', 'H', 'U', 'S', 'D', 'B'};
+const uint32_t BINARY_VERSION = 1;
+
+class BinaryHeader {
+    public:
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t numSequences;
+        uint64_t numRecords;
+};
+
+/*
+    Map a whole file read-only, the mapping is released with the last reference to it
+*/
+std::shared_ptr<void> mapFile(const std::string &path, size_t &length);
+/*
+    Load the two-file CSV layout in parallel. Both files are split into chunks of whole lines
+    which are parsed concurrently, and when sidulItems is given each chunk also builds the
+    SIDULs of its own sequences while parsing them, which are merged once all chunks are done.
+*/
+Database readCSVData(const std::string &inputDataPath, std::unordered_map<unsigned int, std::shared_ptr<Pattern>> *sidulItems);
+bool isBinaryData(const std::string &path);
+Database readBinaryData(const std::string &path);
+void writeBinaryData(const Database &database, const std::string &path);
@@ -0,0 +1,82 @@
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include "omp.h"
+#include "fixed.h"
+
+/*
+    Largest number of decimals of a scale, 10^6
+*/
+const int MAX_DECIMALS = 6;
+
+std::string UtilityScale::name() const {
+    switch (this->type) {
+        case UtilityType::INT32: return "int32";
+        case UtilityType::INT64: return "int64";
+        default: return "float";
+    }
+}
+
+/*
+    Number of decimals of a utility, up to the precision of a float, or -1 when it needs more
+    than MAX_DECIMALS or is negative
+*/
+static int decimals(float utility) {
+    if (utility < 0) return -1;
+    double scaled = utility;
+    for (int decimals = 0; decimals <= MAX_DECIMALS; ++decimals, scaled *= 10)
+        if (std::fabs(scaled - std::round(scaled)) <= scaled * std::ldexp(1.0, -22)) return decimals;
+    return -1;
+}
+
+UtilityScale detect_scale(const MiningContext &context) {
+    int maxDecimals = 0;
+    double total = 0;
+    #pragma omp parallel for schedule(dynamic, 16) reduction(max:maxDecimals) reduction(+:total)
+    for (size_t idx = 0; idx < context.items.size(); ++idx) {
+        for (auto utility : context.items[idx]->siduls.utility) {
+            const int utilityDecimals = decimals(utility);
+            maxDecimals = utilityDecimals < 0 ? MAX_DECIMALS + 1 : std::max(maxDecimals, utilityDecimals);
+            total += utility;
+        }
+    }
+    UtilityScale scale;
+    if (maxDecimals > MAX_DECIMALS) return scale;
+    scale.scale = std::pow(10.0, maxDecimals);
+    /*
+        Rounding each utility to the scale may add up to half a unit per instance, which the
+        margin of a unit per thousandth of the total leaves room for
+    */
+    const double bound = total * scale.scale * 1.001 + 1;
+    if (bound < std::numeric_limits<int32_t>::max()) scale.type = UtilityType::INT32;
+    else if (bound < std::ldexp(1.0, 62)) scale.type = UtilityType::INT64;
+    else scale.scale = 1;
+    return scale;
+}
+
+template <typename Utility>
+Utility to_threshold(float minUtility, double scale) {
+    if constexpr (std::is_floating_point<Utility>::value) return minUtility;
+    /*
+        The threshold is a float too, a value meant to be on the scale is taken as such
+    */
+    const double scaled = minUtility * scale;
+    double threshold = std::round(scaled);
+    if (std::fabs(scaled - threshold) > std::fabs(scaled) * std::ldexp(1.0, -22)) threshold = std::ceil(scaled);
+    if (threshold <= std::numeric_limits<Utility>::lowest()) return std::numeric_limits<Utility>::lowest();
+    if (threshold >= std::numeric_limits<Utility>::max()) return std::numeric_limits<Utility>::max();
+    return threshold;
+}
+
+template <typename Utility>
+float from_fixed(Utility utility, double scale) {
+    if constexpr (std::is_floating_point<Utility>::value) return utility;
+    return utility / scale;
+}
+
+template float to_threshold(float minUtility, double scale);
+template int32_t to_threshold(float minUtility, double scale);
+template int64_t to_threshold(float minUtility, double scale);
+template float from_fixed(float utility, double scale);
+template float from_fixed(int32_t utility, double scale);
+template float from_fixed(int64_t utility, double scale);
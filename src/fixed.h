@@ -0,0 +1,35 @@
+/*
+    Fixed-point utilities for the search.
+
+    Utilities are loaded as floats, whose sums drift from the exact ones over many sequences
+    and may flip a comparison against the threshold. When every utility of the items searched
+    is a multiple of 1/scale, scale being a power of ten up to 10^6, the search runs over
+    integers counting units of 1/scale instead, and all its sums are exact. No sum of the search
+    exceeds the total utility of the sequences, so the narrowest integer type holding that total
+    is chosen. The search keeps floats for utilities that have no such scale.
+*/
+#pragma once
+#include <string>
+#include "models.h"
+
+enum class UtilityType { FLOAT, INT32, INT64 };
+
+class UtilityScale {
+    public:
+        UtilityType type = UtilityType::FLOAT;
+        double scale = 1;
+
+        std::string name() const;
+};
+
+UtilityScale detect_scale(const MiningContext &context);
+/*
+    The least utility at or above minUtility, saturated at the largest one
+*/
+template <typename Utility>
+Utility to_threshold(float minUtility, double scale);
+/*
+    Utility in the units of the input
+*/
+template <typename Utility>
+float from_fixed(Utility utility, double scale);
@@ -0,0 +1,112 @@
+/*
+    Generate a synthetic dataset in the two-file CSV layout read by the miner.
+
+        $ generate OUTPUT_DIR [OPTIONS]
+
+    Items are drawn from a Zipf distribution over the alphabet, item 1 being the most frequent,
+    and itemsets hold distinct items in ascending order. Sequence lengths and itemset sizes are
+    uniform around their mean. Utilities are positive integers up to --max-utility.
+*/
+#include <cmath>
+#include <random>
+#include <set>
+#include <sys/stat.h>
+#include "utils.h"
+
+class GeneratorOptions {
+    public:
+        unsigned int sequences = 1000;
+        unsigned int length = 10;
+        unsigned int itemset = 3;
+        unsigned int items = 1000;
+        double zipf = 1.0;
+        std::string utility = "uniform";
+        unsigned int maxUtility = 10;
+        unsigned int seed = 1;
+};
+
+int usage(const char *program) {
+    std::cerr << "Usage: " << program << " OUTPUT_DIR [OPTIONS]" << std::endl <<
+    "  --sequences N       number of sequences (1000)" << std::endl <<
+    "  --length L          mean number of itemsets of a sequence (10)" << std::endl <<
+    "  --itemset S         mean number of items of an itemset (3)" << std::endl <<
+    "  --items A           size of the alphabet (1000)" << std::endl <<
+    "  --zipf Z            skew of the item frequencies, 0 for uniform (1.0)" << std::endl <<
+    "  --utility DIST      uniform, exponential or lognormal (uniform)" << std::endl <<
+    "  --max-utility U     largest utility of an item (10)" << std::endl <<
+    "  --seed N            seed of the random generator (1)" << std::endl;
+    return 1;
+}
+
+/*
+    Uniform integer in [1, 2 * mean - 1], whose mean is the given one
+*/
+unsigned int around(unsigned int mean, std::mt19937 &generator) {
+    return std::uniform_int_distribution<unsigned int>(1, std::max(1u, 2 * mean - 1))(generator);
+}
+
+int main(int argvc, char** argv) {
+    if (argvc < 2 || argvc % 2 != 0 || argv[1][0] == '-') return usage(argv[0]);
+    const std::string outputPath = argv[1];
+    GeneratorOptions options;
+    for (int arg = 2; arg < argvc; arg += 2) {
+        const std::string option = argv[arg], value = argv[arg + 1];
+        if (option == "--sequences") options.sequences = std::stoul(value);
+        else if (option == "--length") options.length = std::stoul(value);
+        else if (option == "--itemset") options.itemset = std::stoul(value);
+        else if (option == "--items") options.items = std::stoul(value);
+        else if (option == "--zipf") options.zipf = std::stod(value);
+        else if (option == "--utility") options.utility = value;
+        else if (option == "--max-utility") options.maxUtility = std::stoul(value);
+        else if (option == "--seed") options.seed = std::stoul(value);
+        else return usage(argv[0]);
+    }
+    if (options.items == 0 || options.maxUtility == 0) return usage(argv[0]);
+    if (options.utility != "uniform" && options.utility != "exponential" && options.utility != "lognormal") return usage(argv[0]);
+
+    std::mt19937 generator(options.seed);
+    std::vector<double> weights(options.items);
+    for (unsigned int rank = 0; rank < options.items; ++rank) weights[rank] = 1.0 / std::pow(rank + 1, options.zipf);
+    std::discrete_distribution<unsigned int> item(weights.begin(), weights.end());
+
+    std::uniform_int_distribution<unsigned int> uniformUtility(1, options.maxUtility);
+    std::exponential_distribution<double> exponentialUtility(4.0 / options.maxUtility);
+    std::lognormal_distribution<double> lognormalUtility(std::log(options.maxUtility / 4.0), 1.0);
+    auto utility = [&]() -> unsigned int {
+        if (options.utility == "uniform") return uniformUtility(generator);
+        double value = options.utility == "exponential" ? exponentialUtility(generator) : lognormalUtility(generator);
+        return std::min<double>(options.maxUtility, 1 + std::floor(value));
+    };
+
+    mkdir(outputPath.c_str(), 0755);
+    std::ofstream sequencesFile(outputPath + "/" + SEQUENCES_FILE), utilitiesFile(outputPath + "/" + UTILITIES_FILE);
+    if (!sequencesFile || !utilitiesFile) {
+        std::cerr << "Cannot write to " << outputPath << std::endl;
+        return 1;
+    }
+    size_t numRecords = 0;
+    for (unsigned int seqID = 0; seqID < options.sequences; ++seqID) {
+        const unsigned int length = around(options.length, generator);
+        for (unsigned int position = 0; position < length; ++position) {
+            std::set<unsigned int> itemset;
+            const unsigned int size = std::min(around(options.itemset, generator), options.items);
+            while (itemset.size() < size) itemset.insert(item(generator) + 1);
+            if (position) {
+                sequencesFile << '\t' << END_ITEMSET << '\t';
+                utilitiesFile << "\t0\t";
+            }
+            bool first = true;
+            for (auto id : itemset) {
+                sequencesFile << (first ? "" : "\t") << id;
+                utilitiesFile << (first ? "" : "\t") << utility();
+                first = false;
+            }
+            numRecords += itemset.size();
+        }
+        sequencesFile << '\n';
+        utilitiesFile << '\n';
+    }
+    std::cout << "# sequences: " << options.sequences << ", # records: " << numRecords << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,379 @@
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "omp.h"
+#include "index.h"
+#include "utils.h"
+
+const uint64_t HASH_OFFSET = 0xcbf29ce484222325ULL;
+const uint64_t HASH_PRIME = 0x100000001b3ULL;
+
+static inline uint64_t mix(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * HASH_PRIME;
+    return hash ^ (hash >> 29);
+}
+
+/*
+    FNV-1a over 64-bit words, with a shift folding the high bits back into the low ones. Chunks
+    of a fixed length are hashed in parallel and their hashes combined in order, so the result
+    does not depend on the number of threads.
+*/
+static uint64_t hashFile(const std::string &path) {
+    const size_t CHUNK_LENGTH = 1 << 20;
+    size_t length;
+    std::shared_ptr<void> mapping = mapFile(path, length);
+    const char *data = static_cast<const char*>(mapping.get());
+    const size_t numChunks = (length + CHUNK_LENGTH - 1) / CHUNK_LENGTH;
+    std::vector<uint64_t> chunkHashes(numChunks);
+    #pragma omp parallel for schedule(static)
+    for (size_t c = 0; c < numChunks; ++c) {
+        const char *cursor = data + c * CHUNK_LENGTH, *end = cursor + std::min(CHUNK_LENGTH, length - c * CHUNK_LENGTH);
+        uint64_t hash = HASH_OFFSET;
+        for (; cursor + sizeof(uint64_t) <= end; cursor += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, cursor, sizeof(word));
+            hash = mix(hash, word);
+        }
+        for (; cursor < end; ++cursor) hash = mix(hash, static_cast<unsigned char>(*cursor));
+        chunkHashes[c] = hash;
+    }
+    uint64_t hash = mix(HASH_OFFSET, length);
+    for (auto chunkHash : chunkHashes) hash = mix(hash, chunkHash);
+    return hash;
+}
+
+std::string indexPath(const std::string &inputDataPath) {
+    if (isBinaryData(inputDataPath)) return inputDataPath + ".index";
+    return inputDataPath + "/" + INDEX_FILE;
+}
+
+uint64_t hashInputData(const std::string &inputDataPath) {
+    if (isBinaryData(inputDataPath)) return hashFile(inputDataPath);
+    return mix(hashFile(inputDataPath + "/" + SEQUENCES_FILE), hashFile(inputDataPath + "/" + UTILITIES_FILE));
+}
+
+bool readIndex(const std::string &path, uint64_t hash, Index &index) {
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode)) return false;
+    size_t length;
+    std::shared_ptr<void> mapping = mapFile(path, length);
+    if (length < sizeof(IndexHeader)) return false;
+
+    const char *data = static_cast<const char*>(mapping.get());
+    const IndexHeader *header = reinterpret_cast<const IndexHeader*>(data);
+    if (
+        std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header->version != INDEX_VERSION ||
+        header->hash != hash
+    ) return false;
+
+    index.header = header;
+    index.recordOffsets = reinterpret_cast<const uint64_t*>(data + sizeof(IndexHeader));
+    index.items = reinterpret_cast<const IndexItem*>(index.recordOffsets + header->numSequences + 1);
+    index.sizes = reinterpret_cast<const uint32_t*>(index.items + header->numItems);
+    index.sids = index.sizes + header->numSequences;
+    index.offsets = index.sids + header->numSids;
+    index.utility = reinterpret_cast<const float*>(index.offsets + header->numSids + header->numItems);
+    index.position = reinterpret_cast<const uint32_t*>(index.utility + header->numInstances);
+    index.record = index.position + header->numInstances;
+    if (reinterpret_cast<const char*>(index.record + header->numInstances) > data + length) return false;
+    index.mapping = mapping;
+    return true;
+}
+
+template <typename Vector>
+static void writeVector(std::ofstream &file, const Vector &values) {
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+}
+
+void writeIndex(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    uint64_t hash,
+    const std::string &path
+) {
+    std::vector<std::shared_ptr<Pattern>> items;
+    for (auto &item : sidulItems) items.push_back(item.second);
+    std::sort(
+        items.begin(),
+        items.end(),
+        [](const std::shared_ptr<Pattern> &a, const std::shared_ptr<Pattern> &b) { return a->lastItem < b->lastItem; }
+    );
+    std::unordered_map<int, unsigned int> itemIdx;
+    for (unsigned int idx = 0; idx < items.size(); ++idx) itemIdx[items[idx]->lastItem] = idx;
+
+    /*
+        Sequences are scanned in the order their instances were added to the SIDULs, so the
+        records of an item come in the order of its instances
+    */
+    std::vector<std::vector<uint32_t>> records(items.size());
+    std::vector<uint64_t> recordOffsets(database.sequences.size() + 1, 0);
+    for (unsigned int seqID = 0; seqID < database.sequences.size(); ++seqID) {
+        uint32_t record = 0;
+        for (auto &item : database.sequences[seqID])
+            if (item.id != END_ITEMSET && item.id != END_SEQUENCE) records[itemIdx.at(item.id)].push_back(record++);
+        recordOffsets[seqID + 1] = recordOffsets[seqID] + record;
+    }
+
+    /*
+        Partitions of a run may all be building the index at the same time
+    */
+    const std::string partialPath = path + ".partial." + std::to_string(getpid());
+    std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("cannot write " + partialPath);
+
+    IndexHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.reserved = 0;
+    header.hash = hash;
+    header.numSequences = database.sequences.size();
+    header.numItems = items.size();
+    header.numSids = 0;
+    header.numInstances = 0;
+    std::vector<IndexItem> indexItems;
+    for (auto &item : items) {
+        /*
+            Summed in the order of the sequences, as WPS_by_LRU_and_Support does
+        */
+        float LRU = 0;
+        for (auto sid : item->siduls.sids) LRU += database.sequences[sid].utility;
+        indexItems.push_back({item->lastItem, item->siduls.size(), LRU, 0, header.numSids, header.numInstances});
+        header.numSids += item->siduls.size();
+        header.numInstances += item->siduls.utility.size();
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeVector(file, recordOffsets);
+    writeVector(file, indexItems);
+    for (auto &sequence : database.sequences) {
+        const uint32_t size = sequence.size;
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    for (auto &item : items) writeVector(file, item->siduls.sids);
+    for (auto &item : items) writeVector(file, item->siduls.offsets);
+    for (auto &item : items) writeVector(file, item->siduls.utility);
+    for (auto &item : items) writeVector(file, item->siduls.position);
+    for (auto &itemRecords : records) writeVector(file, itemRecords);
+    file.close();
+    if (!file || std::rename(partialPath.c_str(), path.c_str()) != 0) throw std::runtime_error("cannot write " + path);
+}
+
+/*
+    Item record of a pruned sequence, its position being the one before pruning until the
+    sequence is laid out
+*/
+class PrunedRecord {
+    public:
+        float utility;
+        float rem;
+        unsigned int position;
+        unsigned int item;
+        bool isKept;
+};
+
+/*
+    The instances of an item are spread over the whole dataset, so sequences are handled in
+    blocks whose records stay in cache. blocks holds the first sequence of each block followed
+    by the number of sequences.
+*/
+static std::vector<size_t> split_blocks(const Index &index, uint64_t &maxBlockRecords) {
+    const uint64_t BLOCK_RECORDS = 1 << 15;
+    const size_t numSeqs = index.header->numSequences;
+    std::vector<size_t> blocks(1, 0);
+    maxBlockRecords = 0;
+    for (size_t seqID = 0; seqID < numSeqs; ++seqID) {
+        if (index.recordOffsets[seqID + 1] - index.recordOffsets[blocks.back()] <= BLOCK_RECORDS) continue;
+        if (seqID > blocks.back()) {
+            maxBlockRecords = std::max(maxBlockRecords, index.recordOffsets[seqID] - index.recordOffsets[blocks.back()]);
+            blocks.push_back(seqID);
+        }
+    }
+    maxBlockRecords = std::max(maxBlockRecords, index.recordOffsets[numSeqs] - index.recordOffsets[blocks.back()]);
+    blocks.push_back(numSeqs);
+    return blocks;
+}
+
+/*
+    Scatter the instances of the kept items within a block back to their records, the idx-th
+    kept item being numbered idx. Every item keeps its place in its SIDUL from one block to the
+    next in scattered. Called by all the threads of a parallel region.
+*/
+static void scatter_block(
+    const Index &index,
+    const std::vector<unsigned int> &keptItems,
+    size_t firstSeq,
+    size_t lastSeq,
+    std::vector<PrunedRecord> &records,
+    std::vector<uint32_t> &scattered
+) {
+    const uint64_t blockRecord = index.recordOffsets[firstSeq];
+    #pragma omp for schedule(static)
+    for (uint64_t idx = 0; idx < index.recordOffsets[lastSeq] - blockRecord; ++idx) records[idx].isKept = false;
+
+    #pragma omp for schedule(dynamic, 16)
+    for (size_t idx = 0; idx < keptItems.size(); ++idx) {
+        const IndexItem &item = index.items[keptItems[idx]];
+        const uint32_t *offsets = index.offsets + item.firstSid + keptItems[idx];
+        uint32_t &sidIdx = scattered[idx];
+        for (; sidIdx < item.support && index.sids[item.firstSid + sidIdx] < lastSeq; ++sidIdx) {
+            const uint64_t firstRecord = index.recordOffsets[index.sids[item.firstSid + sidIdx]] - blockRecord;
+            for (uint64_t instance = item.firstInstance + offsets[sidIdx]; instance < item.firstInstance + offsets[sidIdx + 1]; ++instance)
+                records[firstRecord + index.record[instance]] = {index.utility[instance], 0, index.position[instance], (unsigned int)idx, true};
+        }
+    }
+}
+
+std::unordered_map<unsigned int, std::shared_ptr<Pattern>> shrink_database(
+    const Index &index,
+    float MIN_SUPP,
+    float MIN_UTILITY,
+    std::vector<unsigned int> &sequenceSizes,
+    unsigned int &numSequences,
+    std::vector<int> &originalIds
+) {
+    const size_t numSeqs = index.header->numSequences;
+    std::vector<unsigned int> keptItems;
+    for (unsigned int idx = 0; idx < index.header->numItems; ++idx)
+        if (index.items[idx].support >= MIN_SUPP && index.items[idx].LRU >= MIN_UTILITY) keptItems.push_back(idx);
+
+    uint64_t maxBlockRecords;
+    const std::vector<size_t> blocks = split_blocks(index, maxBlockRecords);
+    std::vector<PrunedRecord> records(maxBlockRecords);
+
+    /*
+        Every round sums the utilities of the sequences pruned of the items removed so far, in
+        the order of their records as WPS_by_LRU_and_Support does, and removes the items whose
+        LRU fell below the threshold
+    */
+    std::vector<float> sequenceUtilities(numSeqs);
+    for (;;) {
+        std::vector<uint32_t> scattered(keptItems.size(), 0);
+        #pragma omp parallel
+        for (size_t block = 0; block + 1 < blocks.size(); ++block) {
+            const size_t firstSeq = blocks[block], lastSeq = blocks[block + 1];
+            const uint64_t blockRecord = index.recordOffsets[firstSeq];
+            scatter_block(index, keptItems, firstSeq, lastSeq, records, scattered);
+            #pragma omp for schedule(dynamic, 256)
+            for (size_t seqID = firstSeq; seqID < lastSeq; ++seqID) {
+                float sequenceUtility = 0;
+                for (uint64_t idx = index.recordOffsets[seqID] - blockRecord; idx < index.recordOffsets[seqID + 1] - blockRecord; ++idx)
+                    if (records[idx].isKept) sequenceUtility += records[idx].utility;
+                sequenceUtilities[seqID] = sequenceUtility;
+            }
+        }
+        std::vector<char> isKept(keptItems.size());
+        #pragma omp parallel for schedule(dynamic, 16)
+        for (size_t idx = 0; idx < keptItems.size(); ++idx) {
+            const IndexItem &item = index.items[keptItems[idx]];
+            float LRU = 0;
+            for (uint32_t sidIdx = 0; sidIdx < item.support; ++sidIdx) LRU += sequenceUtilities[index.sids[item.firstSid + sidIdx]];
+            isKept[idx] = LRU >= MIN_UTILITY;
+        }
+        if (std::count(isKept.begin(), isKept.end(), true) == (long)keptItems.size()) break;
+        std::vector<unsigned int> stillKept;
+        for (size_t idx = 0; idx < keptItems.size(); ++idx)
+            if (isKept[idx]) stillKept.push_back(keptItems[idx]);
+        keptItems = std::move(stillKept);
+    }
+
+    /*
+        Items are renumbered by their rank in ascending order of support, as shrink_database
+        does over a database
+    */
+    std::stable_sort(keptItems.begin(), keptItems.end(), [&](unsigned int a, unsigned int b) {
+        return index.items[a].support < index.items[b].support;
+    });
+    originalIds.resize(keptItems.size());
+    std::vector<std::shared_ptr<Pattern>> items(keptItems.size());
+    for (size_t idx = 0; idx < keptItems.size(); ++idx) {
+        const IndexItem &item = index.items[keptItems[idx]];
+        originalIds[idx] = item.id;
+        items[idx] = std::make_shared<Pattern>();
+        items[idx]->lastItem = idx;
+        ++items[idx]->size;
+        items[idx]->items.push_back(idx);
+        items[idx]->siduls.reserve(item.support, index.offsets[item.firstSid + keptItems[idx] + item.support]);
+    }
+
+    /*
+        In each block, the records scattered lay out the pruned sequences in order, and the
+        instances are gathered again once their remaining utilities and positions are known
+    */
+    std::vector<uint32_t> scattered(keptItems.size(), 0), gathered(keptItems.size(), 0);
+    sequenceSizes.assign(numSeqs, 0);
+    unsigned int nonEmpty = 0;
+    #pragma omp parallel
+    {
+        std::vector<uint64_t> itemset;
+        for (size_t block = 0; block + 1 < blocks.size(); ++block) {
+            const size_t firstSeq = blocks[block], lastSeq = blocks[block + 1];
+            const uint64_t blockRecord = index.recordOffsets[firstSeq];
+            scatter_block(index, keptItems, firstSeq, lastSeq, records, scattered);
+
+            /*
+                Remaining utilities and positions within the pruned sequences, computed as
+                construct_siduls does with the items of every itemset in the order of their
+                new ids. Itemsets left empty are dropped, and a last itemset not ended by a
+                separator is not counted in the size, as WPS_by_LRU_and_Support does.
+            */
+            #pragma omp for schedule(dynamic, 256) reduction(+:nonEmpty)
+            for (size_t seqID = firstSeq; seqID < lastSeq; ++seqID) {
+                const uint64_t begin = index.recordOffsets[seqID] - blockRecord, end = index.recordOffsets[seqID + 1] - blockRecord;
+                float sequenceUtility = 0;
+                bool hasItem = false;
+                for (uint64_t idx = begin; idx < end; ++idx) {
+                    if (!records[idx].isKept) continue;
+                    sequenceUtility += records[idx].utility;
+                    hasItem = true;
+                }
+                if (!hasItem) continue;
+                ++nonEmpty;
+
+                float prefixUtility = 0;
+                unsigned int itemsetIdx = 0, lastPosition = 0;
+                for (uint64_t idx = begin; idx <= end; ++idx) {
+                    if (idx < end && !records[idx].isKept) continue;
+                    if (idx == end || (!itemset.empty() && records[idx].position != lastPosition)) {
+                        std::sort(itemset.begin(), itemset.end(), [&](uint64_t a, uint64_t b) { return records[a].item < records[b].item; });
+                        for (auto record : itemset) {
+                            records[record].rem = sequenceUtility - (prefixUtility += records[record].utility);
+                            records[record].position = itemsetIdx;
+                        }
+                        itemset.clear();
+                        if (idx == end) break;
+                        ++itemsetIdx;
+                    }
+                    lastPosition = records[idx].position;
+                    itemset.push_back(idx);
+                }
+                sequenceSizes[seqID] = itemsetIdx + (lastPosition < index.sizes[seqID] ? 1 : 0);
+            }
+
+            #pragma omp for schedule(dynamic, 16)
+            for (size_t idx = 0; idx < keptItems.size(); ++idx) {
+                const IndexItem &item = index.items[keptItems[idx]];
+                const uint32_t *offsets = index.offsets + item.firstSid + keptItems[idx];
+                Pattern &sidulItem = *items[idx];
+                Sidul &siduls = sidulItem.siduls;
+                uint32_t &sidIdx = gathered[idx];
+                for (; sidIdx < item.support && index.sids[item.firstSid + sidIdx] < lastSeq; ++sidIdx) {
+                    const unsigned int sid = index.sids[item.firstSid + sidIdx];
+                    const uint64_t firstRecord = index.recordOffsets[sid] - blockRecord;
+                    for (uint64_t instance = item.firstInstance + offsets[sidIdx]; instance < item.firstInstance + offsets[sidIdx + 1]; ++instance) {
+                        const PrunedRecord &record = records[firstRecord + index.record[instance]];
+                        siduls.addInstance(sid, record.utility, record.rem, record.position);
+                    }
+                    add_sequence_metrics(sidulItem, sidIdx, sequenceSizes[sid]);
+                }
+            }
+        }
+    }
+    numSequences = nonEmpty;
+
+    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> sidulItems;
+    for (auto &item : items) sidulItems[item->lastItem] = item;
+    return sidulItems;
+}
@@ -0,0 +1,105 @@
+/*
+    Preprocessed index of a dataset, saved next to it so that runs with other thresholds skip
+    loading and indexing it. All fields are in native byte order:
+
+        IndexHeader
+        uint64_t  recordOffsets[numSequences + 1]  index of the first item record of each sequence
+        IndexItem items[numItems]                  in ascending order of item id
+        uint32_t  sizes[numSequences]              number of itemsets of each sequence
+        uint32_t  sids[numSids]
+        uint32_t  offsets[numSids + numItems]
+        float     utility[numInstances]
+        uint32_t  position[numInstances]
+        uint32_t  record[numInstances]
+
+    These are the SIDULs of the items over the sequences as loaded, before WPS_by_LRU_and_Support.
+    The sids of an item start at firstSid and its offsets, relative to its firstInstance, at
+    firstSid plus its index. Item records are numbered without the separators, and record holds
+    the number of an instance within its sequence, from which the remaining utilities and the
+    positions of a pruned sequence are found again.
+
+    The index is only valid for the content it was built from, whose hash it keeps.
+*/
+#pragma once
+#include <string>
+#include <unordered_map>
+#include "models.h"
+
+const char INDEX_MAGIC[8] = {'P', 'F', 'C', 'H', 'U', 'S', 'I', 'X'};
+const uint32_t INDEX_VERSION = 1;
+const std::string INDEX_FILE = "index.bin";
+
+class IndexHeader {
+    public:
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t hash;
+        uint64_t numSequences;
+        uint64_t numItems;
+        uint64_t numSids;
+        uint64_t numInstances;
+};
+
+class IndexItem {
+    public:
+        int32_t id;
+        uint32_t support;
+        float LRU;
+        uint32_t reserved;
+        uint64_t firstSid;
+        uint64_t firstInstance;
+};
+
+/*
+    Views into a mapped index, valid as long as the mapping is held
+*/
+class Index {
+    public:
+        std::shared_ptr<void> mapping;
+        const IndexHeader *header;
+        const uint64_t *recordOffsets;
+        const IndexItem *items;
+        const uint32_t *sizes;
+        const uint32_t *sids;
+        const uint32_t *offsets;
+        const float *utility;
+        const uint32_t *position;
+        const uint32_t *record;
+};
+
+/*
+    index.bin inside a dataset directory, or the binary dataset's path with an .index suffix
+*/
+std::string indexPath(const std::string &inputDataPath);
+/*
+    Hash of the content of the dataset files, not meant to resist deliberate collisions
+*/
+uint64_t hashInputData(const std::string &inputDataPath);
+/*
+    Map the index at path, false when there is none or it was built from another content or
+    by another version, in which case it is to be built again
+*/
+bool readIndex(const std::string &path, uint64_t hash, Index &index);
+/*
+    The index is written next to path and renamed over it once complete
+*/
+void writeIndex(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    uint64_t hash,
+    const std::string &path
+);
+/*
+    shrink_database applied to the index, followed by construct_siduls over the pruned sequences:
+    the SIDULs, metrics, sequence sizes and new item ids are the same as theirs. numSequences is
+    the number of sequences left with an item.
+*/
+std::unordered_map<unsigned int, std::shared_ptr<Pattern>> shrink_database(
+    const Index &index,
+    float MIN_SUPP,
+    float MIN_UTILITY,
+    std::vector<unsigned int> &sequenceSizes,
+    unsigned int &numSequences,
+    std::vector<int> &originalIds
+);
@@ -0,0 +1,237 @@
+/*
+    Micro-benchmark of the extension kernels on long sequences against the implementations they
+    replaced: hash-map position matching for i-extensions and a rescan of the pattern's instances
+    for every item instance for s-extensions. Results of both are checked to be identical.
+
+    The metric kernels of every set the CPU supports are then checked against the scalar ones
+    over many ranges of random SIDULs of every layout, and timed over whole SIDULs.
+
+        $ kernels_bench [REPETITIONS]
+*/
+#include <random>
+#include "omp.h"
+#include "utils.h"
+#include "metrics.h"
+
+const unsigned int NUM_SEQUENCES = 32;
+const unsigned int SEQUENCE_SIZES[] = {256, 1024, 4096, 16384};
+const unsigned int METRIC_SEQUENCES = 1 << 16;
+const unsigned int METRIC_RANGES = 2000;
+
+static void add_metrics(Pattern &extendedPattern, unsigned int sid, float uminInSequence, const MiningContext &context) {
+    if (uminInSequence == std::numeric_limits<float>::max()) return;
+    const Sidul &extendedSiduls = extendedPattern.siduls;
+    const unsigned int first = extendedSiduls.begin(extendedSiduls.size() - 1);
+    extendedPattern.umin += uminInSequence;
+    extendedPattern.RBU += (extendedSiduls.utility[first] + extendedSiduls.rem[first]);
+    extendedPattern.SE += (context.sequenceSizes[sid] - (extendedSiduls.position[first]+1) + 1);
+    extendedPattern.SLIP += extendedSiduls.end(extendedSiduls.size() - 1) - first;
+}
+
+static void legacy_i_ext(Pattern &extendedPattern, const Pattern &pattern, const Pattern &item, const MiningContext &context) {
+    const Sidul &patternSiduls = pattern.siduls, &itemSiduls = item.siduls;
+    unsigned int patternIdx = 0, itemIdx = 0;
+    while (patternIdx < patternSiduls.size() && itemIdx < itemSiduls.size()) {
+        if (patternSiduls.sids[patternIdx] < itemSiduls.sids[itemIdx]) ++patternIdx;
+        else if (patternSiduls.sids[patternIdx] > itemSiduls.sids[itemIdx]) ++itemIdx;
+        else {
+            const unsigned int sid = patternSiduls.sids[patternIdx];
+            float uminInSequence = std::numeric_limits<float>::max();
+            std::unordered_map<unsigned int, unsigned int> commonPoss;
+            for (unsigned int instance = itemSiduls.begin(itemIdx); instance < itemSiduls.end(itemIdx); ++instance)
+                commonPoss.insert({itemSiduls.position[instance], instance});
+            for (unsigned int instance = patternSiduls.begin(patternIdx); instance < patternSiduls.end(patternIdx); ++instance) {
+                auto commonPos = commonPoss.find(patternSiduls.position[instance]);
+                if (commonPos != commonPoss.end()) {
+                    const float instanceUmin = patternSiduls.utility[instance] + itemSiduls.utility[commonPos->second];
+                    extendedPattern.siduls.addInstance(sid, instanceUmin, itemSiduls.rem[commonPos->second], itemSiduls.position[commonPos->second]);
+                    uminInSequence = std::min(uminInSequence, instanceUmin);
+                }
+            }
+            add_metrics(extendedPattern, sid, uminInSequence, context);
+            ++patternIdx;
+            ++itemIdx;
+        }
+    }
+}
+
+static void legacy_s_ext(Pattern &extendedPattern, const Pattern &pattern, const Pattern &item, const MiningContext &context) {
+    const Sidul &patternSiduls = pattern.siduls, &itemSiduls = item.siduls;
+    unsigned int patternIdx = 0, itemIdx = 0;
+    while (patternIdx < patternSiduls.size() && itemIdx < itemSiduls.size()) {
+        if (patternSiduls.sids[patternIdx] < itemSiduls.sids[itemIdx]) ++patternIdx;
+        else if (patternSiduls.sids[patternIdx] > itemSiduls.sids[itemIdx]) ++itemIdx;
+        else {
+            const unsigned int sid = patternSiduls.sids[patternIdx];
+            float uminInSequence = std::numeric_limits<float>::max();
+            for (unsigned int itemInstance = itemSiduls.begin(itemIdx); itemInstance < itemSiduls.end(itemIdx); ++itemInstance) {
+                float newUmin = std::numeric_limits<float>::max();
+                for (
+                    unsigned int patternInstance = patternSiduls.begin(patternIdx);
+                    patternInstance < patternSiduls.end(patternIdx) &&
+                    patternSiduls.position[patternInstance] < itemSiduls.position[itemInstance];
+                    ++patternInstance
+                ) newUmin = std::min(newUmin, patternSiduls.utility[patternInstance] + itemSiduls.utility[itemInstance]);
+                if (newUmin != std::numeric_limits<float>::max()) {
+                    extendedPattern.siduls.addInstance(sid, newUmin, itemSiduls.rem[itemInstance], itemSiduls.position[itemInstance]);
+                    uminInSequence = std::min(uminInSequence, newUmin);
+                }
+            }
+            add_metrics(extendedPattern, sid, uminInSequence, context);
+            ++patternIdx;
+            ++itemIdx;
+        }
+    }
+}
+
+/*
+    SIDUL occurring at about half of the itemsets of every sequence
+*/
+static void random_siduls(Pattern &pattern, unsigned int sequenceSize, std::mt19937 &generator) {
+    std::uniform_real_distribution<float> utility(1, 100);
+    std::bernoulli_distribution occurs(0.5);
+    for (unsigned int sid = 0; sid < NUM_SEQUENCES; ++sid)
+        for (unsigned int position = 0; position < sequenceSize; ++position)
+            if (occurs(generator)) pattern.siduls.addInstance(sid, utility(generator), utility(generator), position);
+}
+
+static bool same(const Pattern &a, const Pattern &b) {
+    return a.siduls.sids == b.siduls.sids && a.siduls.offsets == b.siduls.offsets &&
+        a.siduls.utility == b.siduls.utility && a.siduls.rem == b.siduls.rem &&
+        a.siduls.position == b.siduls.position &&
+        a.umin == b.umin && a.RBU == b.RBU && a.SE == b.SE && a.SLIP == b.SLIP;
+}
+
+typedef void (*Kernel)(Pattern &, const Pattern &, const Pattern &, const MiningContext &);
+
+static double time_kernel(Kernel kernel, Pattern &result, const Pattern &pattern, const Pattern &item, const MiningContext &context, unsigned int repetitions) {
+    double start = omp_get_wtime();
+    for (unsigned int repetition = 0; repetition < repetitions; ++repetition) {
+        result = Pattern();
+        kernel(result, pattern, item, context);
+    }
+    return (omp_get_wtime() - start) / repetitions * 1e3;
+}
+
+/*
+    SIDUL over METRIC_SEQUENCES sequences spread over the ids of the layout. Most sequences hold
+    a few instances and some many, so that both the scalar and the vector paths of the kernels
+    are taken.
+*/
+template <typename Utility, typename Position, typename Sid>
+static void random_columns(BasicSidul<Utility, Position, Sid> &siduls, std::vector<unsigned int> &sequenceSizes, std::mt19937 &generator) {
+    const unsigned int maxSid = std::min<uint64_t>(std::numeric_limits<Sid>::max(), uint64_t(METRIC_SEQUENCES) * 4);
+    const unsigned int maxSize = std::min<uint64_t>(uint64_t(std::numeric_limits<Position>::max()) + 1, 100000);
+    std::uniform_int_distribution<unsigned int> sid(0, maxSid), size(1, maxSize), fewInstances(1, 3), manyInstances(4, 80);
+    std::uniform_real_distribution<double> utility(0, std::is_floating_point<Utility>::value ? 100 : 1e6);
+    std::bernoulli_distribution isLong(0.3);
+    std::vector<unsigned int> sids(METRIC_SEQUENCES);
+    for (auto &value : sids) value = sid(generator);
+    std::sort(sids.begin(), sids.end());
+    sids.erase(std::unique(sids.begin(), sids.end()), sids.end());
+    sequenceSizes.assign(maxSid + 1, 0);
+    for (auto value : sids) {
+        sequenceSizes[value] = size(generator);
+        const unsigned int instances = std::min(sequenceSizes[value], isLong(generator) ? manyInstances(generator) : fewInstances(generator));
+        std::uniform_int_distribution<unsigned int> itemset(0, sequenceSizes[value] - 1);
+        std::vector<unsigned int> positions;
+        while (positions.size() < instances) {
+            positions.push_back(itemset(generator));
+            std::sort(positions.begin(), positions.end());
+            positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+        }
+        for (auto position : positions) siduls.addInstance(value, utility(generator), utility(generator), position);
+    }
+}
+
+class MetricSums {
+    public:
+        double umin, RBU;
+        unsigned int SE, SLIP;
+
+        bool operator==(const MetricSums &other) const {
+            return umin == other.umin && RBU == other.RBU && SE == other.SE && SLIP == other.SLIP;
+        }
+};
+
+template <typename Utility, typename Position, typename Sid>
+static MetricSums metric_sums(const BasicSidul<Utility, Position, Sid> &siduls, const std::vector<unsigned int> &sequenceSizes, unsigned int first, unsigned int count, KernelSet kernels) {
+    const unsigned int *offsets = siduls.offsets.data() + first;
+    return {
+        double(sumMinima(siduls.utility.data(), offsets, count, kernels)),
+        double(sumFirsts(siduls.utility.data(), siduls.rem.data(), offsets, count, kernels)),
+        sumExtents(siduls.position.data(), siduls.sids.data() + first, offsets, sequenceSizes.data(), count, kernels),
+        countInstances(offsets, count)
+    };
+}
+
+/*
+    Check the kernels of every supported set against the scalar ones over random ranges of
+    sequences, including the empty and whole ones, and time them over the whole SIDUL
+*/
+template <typename Utility, typename Position, typename Sid>
+static bool check_metrics(const std::string &layout, unsigned int repetitions, std::mt19937 &generator) {
+    BasicSidul<Utility, Position, Sid> siduls;
+    std::vector<unsigned int> sequenceSizes;
+    random_columns(siduls, sequenceSizes, generator);
+    std::uniform_int_distribution<unsigned int> first(0, siduls.size()), length(0, 100);
+    bool identical = true;
+    for (auto kernels : {KernelSet::AVX2, KernelSet::AVX512}) {
+        if (kernels > detect_kernels()) continue;
+        for (unsigned int range = 0; range < METRIC_RANGES; ++range) {
+            unsigned int begin = first(generator), count = std::min(siduls.size() - begin, length(generator));
+            if (range == 0) begin = count = 0;
+            if (range == 1) begin = 0, count = siduls.size();
+            identical = identical && metric_sums(siduls, sequenceSizes, begin, count, kernels) == metric_sums(siduls, sequenceSizes, begin, count, KernelSet::SCALAR);
+        }
+        double times[2];
+        for (auto idx : {0, 1}) {
+            const KernelSet timed = idx ? kernels : KernelSet::SCALAR;
+            double start = omp_get_wtime();
+            for (unsigned int repetition = 0; repetition < repetitions; ++repetition)
+                metric_sums(siduls, sequenceSizes, 0, siduls.size(), timed);
+            times[idx] = (omp_get_wtime() - start) / repetitions * 1e3;
+        }
+        std::cout << "metrics " << layout << ", " << kernels_name(kernels) << ", " << times[0] << ", " << times[1] << ", " << times[0] / times[1] << std::endl;
+    }
+    return identical;
+}
+
+int main(int argvc, char** argv) {
+    const unsigned int repetitions = argvc > 1 ? std::stoul(argv[1]) : 5;
+    std::mt19937 generator(42);
+    bool identical = true;
+    std::cout << "kernel, sequence size, old ms, new ms, speedup" << std::endl;
+    for (auto sequenceSize : SEQUENCE_SIZES) {
+        MiningContext context;
+        context.sequenceSizes.assign(NUM_SEQUENCES, sequenceSize);
+        Pattern pattern, item, before, after;
+        random_siduls(pattern, sequenceSize, generator);
+        random_siduls(item, sequenceSize, generator);
+
+        double oldTime = time_kernel(legacy_i_ext, before, pattern, item, context, repetitions);
+        double newTime = time_kernel(construct_i_ext, after, pattern, item, context, repetitions);
+        identical = identical && same(before, after);
+        std::cout << "i-ext, " << sequenceSize << ", " << oldTime << ", " << newTime << ", " << oldTime / newTime << std::endl;
+
+        oldTime = time_kernel(legacy_s_ext, before, pattern, item, context, repetitions);
+        newTime = time_kernel(construct_s_ext, after, pattern, item, context, repetitions);
+        identical = identical && same(before, after);
+        std::cout << "s-ext, " << sequenceSize << ", " << oldTime << ", " << newTime << ", " << oldTime / newTime << std::endl;
+    }
+    if (!identical) {
+        std::cerr << "Results differ from the previous kernels" << std::endl;
+        return 1;
+    }
+
+    std::cout << "metrics, kernels, scalar ms, vector ms, speedup" << std::endl;
+#define CHECK_METRICS(Utility, Position, Sid) \
+    identical = check_metrics<Utility, Position, Sid>(#Utility "/" #Position "/" #Sid, repetitions, generator) && identical;
+    SEARCH_LAYOUTS(CHECK_METRICS)
+#undef CHECK_METRICS
+    if (!identical) {
+        std::cerr << "Results of the metric kernels differ from the scalar ones" << std::endl;
+        return 1;
+    }
+    return 0;
+}
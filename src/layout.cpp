@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include "omp.h"
+#include "layout.h"
+
+SearchLayout detect_layout(const MiningContext &context) {
+    SearchLayout layout;
+    layout.utility = detect_scale(context);
+    /*
+        Positions are below the size of their sequence and sequence ids below their number
+    */
+    const unsigned int maxSize = context.sequenceSizes.empty() ? 0 :
+        *std::max_element(context.sequenceSizes.begin(), context.sequenceSizes.end());
+    if (maxSize <= size_t(std::numeric_limits<uint16_t>::max()) + 1) layout.positionBits = 16;
+    if (context.sequenceSizes.size() <= size_t(std::numeric_limits<uint16_t>::max()) + 1) layout.sidBits = 16;
+    return layout;
+}
+
+/*
+    Instance of an item within a sequence, ordered as the records of the sequence
+*/
+class SequenceInstance {
+    public:
+        unsigned int position;
+        unsigned int item;
+        unsigned int instance;
+};
+
+template <typename Utility, typename Position, typename Sid>
+BasicMiningContext<Utility, Position, Sid> to_layout(const MiningContext &context, double scale) {
+    const bool isFixed = !std::is_floating_point<Utility>::value;
+    BasicMiningContext<Utility, Position, Sid> converted;
+    converted.sequenceSizes = context.sequenceSizes;
+    converted.itemBits = context.itemBits;
+    converted.firstSid = context.firstSid;
+    converted.items.resize(context.items.size());
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (size_t idx = 0; idx < context.items.size(); ++idx) {
+        const Pattern &item = *context.items[idx];
+        std::shared_ptr<BasicPattern<Utility, Position, Sid>> convertedItem = std::make_shared<BasicPattern<Utility, Position, Sid>>();
+        convertedItem->items.assign(item.items.begin(), item.items.end());
+        convertedItem->lastItem = item.lastItem;
+        convertedItem->size = item.size;
+        convertedItem->SE = item.SE;
+        convertedItem->SLIP = item.SLIP;
+        BasicSidul<Utility, Position, Sid> &siduls = convertedItem->siduls;
+        siduls.sids.assign(item.siduls.sids.begin(), item.siduls.sids.end());
+        siduls.offsets.assign(item.siduls.offsets.begin(), item.siduls.offsets.end());
+        siduls.position.assign(item.siduls.position.begin(), item.siduls.position.end());
+        if (isFixed) {
+            siduls.utility.resize(item.siduls.utility.size());
+            for (size_t instance = 0; instance < siduls.utility.size(); ++instance)
+                siduls.utility[instance] = std::llround(item.siduls.utility[instance] * scale);
+            siduls.rem.resize(siduls.utility.size());
+        } else {
+            siduls.utility.assign(item.siduls.utility.begin(), item.siduls.utility.end());
+            siduls.rem.assign(item.siduls.rem.begin(), item.siduls.rem.end());
+            convertedItem->umin = item.umin;
+            convertedItem->RBU = item.RBU;
+        }
+        converted.items[idx] = convertedItem;
+    }
+    if (!isFixed) return converted;
+
+    /*
+        The instances of every sequence are gathered and ordered by position, then by item
+        within an itemset as its records are, and the utilities after each one summed from
+        the end of the sequence
+    */
+    const size_t numSeqs = context.sequenceSizes.size();
+    std::vector<size_t> firstInstances(numSeqs + 1, 0);
+    for (auto &item : converted.items) {
+        const BasicSidul<Utility, Position, Sid> &siduls = item->siduls;
+        for (unsigned int idx = 0; idx < siduls.size(); ++idx) firstInstances[siduls.sids[idx] + 1] += siduls.end(idx) - siduls.begin(idx);
+    }
+    for (size_t seqID = 0; seqID < numSeqs; ++seqID) firstInstances[seqID + 1] += firstInstances[seqID];
+    std::vector<SequenceInstance> instances(firstInstances.back());
+    std::vector<size_t> nextInstances(firstInstances.begin(), firstInstances.end() - 1);
+    for (unsigned int itemIdx = 0; itemIdx < converted.items.size(); ++itemIdx) {
+        const BasicSidul<Utility, Position, Sid> &siduls = converted.items[itemIdx]->siduls;
+        for (unsigned int idx = 0; idx < siduls.size(); ++idx)
+            for (unsigned int instance = siduls.begin(idx); instance < siduls.end(idx); ++instance)
+                instances[nextInstances[siduls.sids[idx]]++] = {siduls.position[instance], itemIdx, instance};
+    }
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t seqID = 0; seqID < numSeqs; ++seqID) {
+        auto begin = instances.begin() + firstInstances[seqID], end = instances.begin() + firstInstances[seqID + 1];
+        std::sort(begin, end, [](const SequenceInstance &a, const SequenceInstance &b) {
+            return a.position < b.position || (a.position == b.position && a.item < b.item);
+        });
+        Utility rem = 0;
+        for (auto instance = end; instance != begin;) {
+            --instance;
+            BasicSidul<Utility, Position, Sid> &siduls = converted.items[instance->item]->siduls;
+            siduls.rem[instance->instance] = rem;
+            rem += siduls.utility[instance->instance];
+        }
+    }
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (size_t idx = 0; idx < converted.items.size(); ++idx) {
+        BasicPattern<Utility, Position, Sid> &item = *converted.items[idx];
+        const BasicSidul<Utility, Position, Sid> &siduls = item.siduls;
+        for (unsigned int sidIdx = 0; sidIdx < siduls.size(); ++sidIdx) {
+            item.umin += *std::min_element(siduls.utility.begin() + siduls.begin(sidIdx), siduls.utility.begin() + siduls.end(sidIdx));
+            item.RBU += siduls.utility[siduls.begin(sidIdx)] + siduls.rem[siduls.begin(sidIdx)];
+        }
+    }
+    return converted;
+}
+
+#define INSTANTIATE(Utility, Position, Sid) \
+    template BasicMiningContext<Utility, Position, Sid> to_layout(const MiningContext &context, double scale);
+SEARCH_LAYOUTS(INSTANTIATE)
+#undef INSTANTIATE
@@ -0,0 +1,32 @@
+/*
+    Element types of the SIDULs of the search.
+
+    Positions index the itemsets of a sequence and sequence ids the sequences of the dataset,
+    so 16 bits hold them whenever no sequence has more than 65536 itemsets, respectively there
+    are no more than 65536 sequences, which is the case for most datasets. The search then runs
+    over SIDULs of those widths, with the utility type of fixed.h, so that more instances fit
+    in a cache line while extensions are merged and the search holds less memory. Every layout
+    of SEARCH_LAYOUTS (models.h) is compiled in and the narrowest one fitting the data is chosen
+    once it is loaded.
+*/
+#pragma once
+#include <string>
+#include "models.h"
+#include "fixed.h"
+
+class SearchLayout {
+    public:
+        UtilityScale utility;
+        unsigned int positionBits = 32;
+        unsigned int sidBits = 32;
+};
+
+SearchLayout detect_layout(const MiningContext &context);
+/*
+    Context of the search over the given layout. Fixed-point remaining utilities are summed
+    again from the instances of the items, in the order of the sequences, rather than converted
+    from their float sums, and so are umin and RBU. They then only cover the items of the
+    context, the only ones an extension may add.
+*/
+template <typename Utility, typename Position, typename Sid>
+BasicMiningContext<Utility, Position, Sid> to_layout(const MiningContext &context, double scale);
@@ -1,303 +1,851 @@
-/*
-    FCHUPatterns are partitioned by both the support and the max size
-    of sequences that share the same support.
-
-    When there's a new candidate pattern that its size is bigger than
-    the max size of the list whose support is equal to the candidate,
-    skip checking since its obviously a new close pattern (it does not
-    have superpatterns with the same support). Otherwise, we need to
-    scan the list to check for both conditions.
-*/
 #include <iostream>
 #include <iomanip>
 #include <limits>
 #include <algorithm>
+#include <type_traits>
 #include "omp.h"
 #include "utils.h"
+#include "store.h"
+#include "stats.h"
+#include "trace.h"
+#include "state.h"
+#include "index.h"
+#include "partition.h"
+#include "layout.h"
+#include "metrics.h"
+#include "budget.h"
+#include "checkpoint.h"
+
+/*
+    Lower bound of the first block of a search node's arena
+*/
+const size_t ARENA_MIN_SIZE = 4096;
 
-class FCloSublist {
+/*
+    Decides which subtrees of the search are worth a task of their own. The work of a subtree is
+    estimated as the number of SIDUL instances of its root times its candidate items, each of
+    which is merged against those instances. Subtrees near the root are always spawned so that
+    skewed first levels are split up, deeper ones only when their estimate reaches minWork, and
+    smaller ones run inline in the parent's task. Nothing is spawned with a single thread, nor
+    once the memory of the search nears its budget (see budget.h).
+*/
+class TaskCutoff {
     public:
-        unsigned int pattern_max_size;
-        std::list<std::shared_ptr<Pattern>> cloPatterns;
+        unsigned int threads;
+        unsigned int depth;
+        size_t minWork;
+        MemoryBudget *memory;
+
+        TaskCutoff() : threads(omp_get_max_threads()), depth(2), minWork(1 << 16), memory(nullptr) {}
+        bool spawn(size_t instances, size_t candidates, unsigned int patternDepth) const {
+            if (this->threads < 2 || (this->memory && this->memory->isNearLimit())) return false;
+            return patternDepth < this->depth || instances * candidates >= this->minWork;
+        }
+        /*
+            Upstream of the arenas of the search nodes
+        */
+        std::pmr::memory_resource* resource() const {
+            return this->memory ? this->memory : std::pmr::get_default_resource();
+        }
 };
 
+class Thresholds {
+    public:
+        float minSupport;
+        float minUtility;
+};
+
+/*
+    A setting of a batch run other than the one searched, with the closed set of the patterns
+    meeting its thresholds
+*/
+template <typename Utility>
+class BatchSetting {
+    public:
+        float minSupport;
+        Utility minUtility;
+        FCloStore<Utility> *store;
+};
+
+template <typename Utility, typename Position, typename Sid>
+void extend(
+    const BasicPattern<Utility, Position, Sid> &pattern,
+    unsigned int itemIdx,
+    bool isSExt,
+    const std::vector<unsigned int> &I,
+    const std::vector<unsigned int> &S,
+    float MIN_SUPP,
+    const UtilityThreshold<Utility> &minUtility,
+    const BasicMiningContext<Utility, Position, Sid> &context,
+    FCloStore<Utility> &FCHUPatterns,
+    SearchStats &stats,
+    const std::vector<BatchSetting<Utility>> &batch,
+    const TaskCutoff &cutoff,
+    Tracer *tracer,
+    TracedTask *traced,
+    unsigned int depth,
+    bool isTask
+);
+
+/*
+    I and S hold indices of the candidate items in context.items, in ascending order of item id.
+    They are owned by the parent's frame, which waits for all its child tasks before returning.
+    depth is the number of extensions from the single item the pattern grew from. traced is the
+    task the node is explored in when it is traced, null otherwise.
+*/
+template <typename Utility, typename Position, typename Sid>
 void dfs(
-    std::shared_ptr<Pattern> pattern,
-    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> I,
-    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> S,
+    const BasicPattern<Utility, Position, Sid> &pattern,
+    const std::vector<unsigned int> &I,
+    const std::vector<unsigned int> &S,
     float MIN_SUPP,
-    float MIN_UTILITY,
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences,
-    std::unordered_map<unsigned int, FCloSublist> &FCHUPatterns,
-    float &syncTime
+    const UtilityThreshold<Utility> &minUtility,
+    const BasicMiningContext<Utility, Position, Sid> &context,
+    FCloStore<Utility> &FCHUPatterns,
+    SearchStats &stats,
+    const std::vector<BatchSetting<Utility>> &batch,
+    const TaskCutoff &cutoff,
+    Tracer *tracer,
+    TracedTask *traced,
+    unsigned int depth
 ) {
     // std::cout <<
     // "DFS called for " << pattern.name <<
     // ", thread=" << omp_get_thread_num() << std::endl;
+    if (context.firstSid && (pattern.siduls.size() == 0 || pattern.siduls.sids.back() < context.firstSid)) return;
+    /*
+        Read once per node, a threshold raised meanwhile is picked up by the next nodes
+    */
+    const Utility MIN_UTILITY = minUtility.get();
+    ++stats.local().nodes;
+    if (traced) traced->node();
     bool do_s_ext = true;
-    if (pattern->umin >= MIN_UTILITY) {
-        bool isClosed = true;
+    if (pattern.umin >= MIN_UTILITY) {
         bool isPruned = false;
+        uint64_t evicted = 0;
+        double lockWait = 0;
 
-        double itime, ftime, exec_time;
-        
-        #pragma omp critical
-        {
-            itime = omp_get_wtime();
-            // std::cout << "Start synchonizing thread=" << omp_get_thread_num() << ", " << pattern.name << std::endl;
-            /*
-                Since the pattern_max_size >= the size of the current candidate, there exists both
-                closed patterns whose size is either (1) >= or (2) < the size of the candidate.
-
-                Do this until all closed patterns are considered or we confirm that the new
-                pattern is not closed.
-            */
-            if (!(FCHUPatterns[pattern->siduls.size()].pattern_max_size < pattern->size)) {
-                // std::cout <<
-                // "There are sequences whose size is >= that of the candidate " <<
-                // pattern.name << std::endl;
-                auto it = FCHUPatterns[pattern->siduls.size()].cloPatterns.begin();
-                while (isClosed && (it != FCHUPatterns[pattern->siduls.size()].cloPatterns.end())) {
-                    /*
-                        (1)
-                    */
-                    if (
-                        ((*it)->size >= pattern->size) &&
-                        ((*it)->name.length() >= pattern->name.length())
-                    ) {
-                        // std::cout <<
-                        // omp_get_thread_num() << " Thread, " <<
-                        // "Checking (candidate size is >=)" << 
-                        // (*it).name << " with " << pattern.name << std::endl;
-                        if (isContainedBy((*it)->name, pattern->name)) {
-                            // std::cout <<
-                            // "Candidate " << pattern.name << " is not closed" << std::endl;
-                            isClosed = false;
-                            if ((*it)->SE == pattern->SE) {
-                                do_s_ext = false;
-                                if ((*it)->SLIP == pattern->SLIP) isPruned = true;
-                            }
-                        } 
-                        /*
-                            When the size is bigger but the candidate is not a subpattern,
-                            continue consider other closed patterns
-                        */
-                        else {
-                            ++it;
-                            // std::cout <<
-                            // "Candidate " << pattern.name << " is not in " << (*it).name << std::endl;
-                        }
-                    } 
-                    /*
-                        (2)
-                    */
-                    else {
-                        // std::cout << 
-                        // omp_get_thread_num() << " Thread, " <<
-                        // "Checking (candidate size is <)" << (*it).name << " with " << pattern.name << std::endl;
-                        if (isContainedBy(pattern->name, (*it)->name)) {
-                            // std::cout <<
-                            // "Deleting " << (*it).name << std::endl;
-                            it = FCHUPatterns[pattern->siduls.size()].cloPatterns.erase(it);
-                        } else {
-                            ++it;
-                            // std::cout <<
-                            // "Candidate " << pattern.name << " is not in " << (*it).name << std::endl;
-                        }
-                    }
-                }
-                if (isClosed) {
-                    // std::cout <<
-                    // omp_get_thread_num() << " Thread, " <<
-                    // "Adding " << pattern.name << std::endl;
-                    FCHUPatterns[pattern->siduls.size()].cloPatterns.push_back(pattern);
-                    // std::cout <<
-                    // "Current list, supp=" << pattern.siduls.size() << ": " << std::endl;
-                    // for (auto it : FCHUPatterns[pattern.siduls.size()].cloPatterns)
-                    //     std::cout << it.name << std::endl;
-                    FCHUPatterns[pattern->siduls.size()].pattern_max_size = std::max(
-                        FCHUPatterns[pattern->siduls.size()].pattern_max_size,
-                        pattern->size
-                    );
-                }
-            }
-            /*
-                The size of all closed patterns in this bucket are less than that of the new candidate
-                -> The candidate becomes a closed pattern
-
-                We go back and eliminate existing closed patterns if any
-            */
-            else {
-                // std::cout <<
-                // "No sequence whose size is >= that of the candidate " <<
-                // pattern.name << std::endl;
-                // auto it = FCHUPatterns[pattern.siduls.size()].cloPatterns.begin();
-                // while (it != FCHUPatterns[pattern.siduls.size()].cloPatterns.end()) {
-                //     std::cout << 
-                //     omp_get_thread_num() << " Thread, " <<
-                //     "Checking (candidate size is >=)" 
-                //     << (*it).name << " with " << pattern.name << std::endl;
-                //     if (isContainedBy(pattern.name, (*it).name)) 
-                //         it = FCHUPatterns[pattern.siduls.size()].cloPatterns.erase(it);
-                //     else it++;
-                // }
-
-                FCHUPatterns[pattern->siduls.size()].cloPatterns.erase(
-                    std::remove_if(
-                        FCHUPatterns[pattern->siduls.size()].cloPatterns.begin(),
-                        FCHUPatterns[pattern->siduls.size()].cloPatterns.end(),
-                        [&](const std::shared_ptr<Pattern> it) {
-                            // bool rs = it.siduls.size() == pattern.siduls.size() &&
-                            // isContainedBy(pattern.name, it.name);
-                            // std::cout << 
-                            // omp_get_thread_num() << " Thread, " <<
-                            // "Checking (candidate size is >=)" 
-                            // << it.name << " with " << pattern.name << std::endl;
-                            return it->siduls.size() == pattern->siduls.size() &&
-                            isContainedBy(pattern->name, it->name);
-                        }
-                    ),
-                    FCHUPatterns[pattern->siduls.size()].cloPatterns.end()
-                );
-
-                // std::cout <<
-                // omp_get_thread_num() << " Thread, " <<
-                // "Adding " << pattern.name << std::endl;
-                FCHUPatterns[pattern->siduls.size()].cloPatterns.push_back(pattern);
-                // std::cout <<
-                // "Current list, supp=" << pattern.siduls.size() << ": " << std::endl;
-                // for (auto it : FCHUPatterns[pattern.siduls.size()].cloPatterns)
-                //     std::cout << it.name << std::endl;
-                FCHUPatterns[pattern->siduls.size()].pattern_max_size = pattern->size;
-            }
-
-            ftime = omp_get_wtime();
-            syncTime += (ftime - itime);
-            // std::cout << "End synchonizing thread=" << omp_get_thread_num() << ", " << pattern->name << std::endl;
+        double itime = omp_get_wtime();
+        const bool isClosed = FCHUPatterns.insert(pattern, do_s_ext, isPruned, evicted, lockWait);
+        /*
+            The settings of a batch only keep their closed sets, the rules pruning the search
+            are those of the store searched
+        */
+        for (auto &setting : batch) {
+            if (pattern.siduls.size() < setting.minSupport || pattern.umin < setting.minUtility) continue;
+            bool settingSExt = true, isSettingPruned = false;
+            uint64_t settingEvicted = 0;
+            setting.store->insert(pattern, settingSExt, isSettingPruned, settingEvicted, lockWait);
         }
+        double ftime = omp_get_wtime();
+        if (traced) traced->waited(lockWait);
+        ThreadStats &local = stats.local();
+        local.syncTime += (ftime - itime);
+        local.lockWait += lockWait;
+        local.insertions += isClosed;
+        local.evictions += evicted;
 
-        if (isPruned) return;
+        if (isPruned) {
+            ++local.prunedBySLIP;
+            return;
+        }
     }
-    if (pattern->RBU < MIN_UTILITY) return;
-    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> newI, newS, newIList;
-    for (auto item : I) {
-        if (item.first > pattern->lastItem) {
-            float extensionLRU = 0;
-            unsigned int extensionSupp = 0;
-            std::unordered_set<int> commonSeqs;
-            for (auto seq : item.second->siduls) commonSeqs.insert(seq.first);
-            for (auto seq : pattern->siduls) {
-                if (commonSeqs.find(seq.first) != commonSeqs.end()) {
-                    std::unordered_set<int> commonPoss;
-                    for (auto instance : item.second->siduls[seq.first]) commonPoss.insert(instance->position);
-                    for (auto instance : pattern->siduls[seq.first]) {
-                        if (commonPoss.find(instance->position) != commonPoss.end()) {
-                            extensionLRU += (pattern->siduls[seq.first][0]->utility + pattern->siduls[seq.first][0]->rem);
-                            ++extensionSupp;
-                            break;
-                        }
+    if (pattern.RBU < MIN_UTILITY) {
+        ++stats.local().prunedByRBU;
+        return;
+    }
+    /*
+        Extensions are screened here but only built by their own subtree once it runs. The
+        instances their SIDUL is sized for estimate the work of the subtree.
+    */
+    std::pmr::monotonic_buffer_resource arena(ARENA_MIN_SIZE, cutoff.resource());
+    std::vector<unsigned int> newI, newS;
+    std::vector<size_t> newIInstances, newSInstances;
+    /*
+        Candidates occurring together with the pattern in fewer than MIN_SUPP sequences are
+        rejected from the bitmaps alone, before any instance is looked at.
+    */
+    const SidulBits patternBits(pattern.siduls, &arena);
+    for (auto itemIdx : I) {
+        const BasicPattern<Utility, Position, Sid> &item = *context.items[itemIdx];
+        if (item.lastItem > pattern.lastItem) {
+            ++stats.local().candidates;
+            const SidulBits &itemBits = context.itemBits[itemIdx];
+            if (patternBits.commonSupport(itemBits) < MIN_SUPP) {
+                ThreadStats &local = stats.local();
+                ++local.rejectedByBitmap;
+                ++local.prunedByExtension;
+                continue;
+            }
+            Utility extensionLRU = 0;
+            unsigned int extensionSupp = 0, extensionSE = 0;
+            size_t extensionInstances = 0;
+            const BasicSidul<Utility, Position, Sid> &itemSiduls = item.siduls, &patternSiduls = pattern.siduls;
+            unsigned int patternSeqIdx = 0, itemSeqIdx = 0;
+            while (patternSeqIdx < patternSiduls.size() && itemSeqIdx < itemSiduls.size()) {
+                if (patternSiduls.sids[patternSeqIdx] < itemSiduls.sids[itemSeqIdx]) ++patternSeqIdx;
+                else if (patternSiduls.sids[patternSeqIdx] > itemSiduls.sids[itemSeqIdx]) ++itemSeqIdx;
+                else {
+                    /*
+                        The first common position is the one of the extension's first instance
+                        in the sequence, which its SE is counted from
+                    */
+                    const long position = patternBits.firstCommonPosition(patternSeqIdx, itemBits, itemSeqIdx);
+                    if (position >= 0) {
+                        const unsigned int first = patternSiduls.begin(patternSeqIdx);
+                        extensionLRU += (patternSiduls.utility[first] + patternSiduls.rem[first]);
+                        ++extensionSupp;
+                        extensionSE += context.sequenceSizes[patternSiduls.sids[patternSeqIdx]] - position;
+                        extensionInstances += std::min(
+                            patternSiduls.end(patternSeqIdx) - first,
+                            itemSiduls.end(itemSeqIdx) - itemSiduls.begin(itemSeqIdx)
+                        );
                     }
+                    ++patternSeqIdx;
+                    ++itemSeqIdx;
                 }
             }
-            // if (extensionLRU >= MIN_UTILITY && extensionSupp >= MIN_SUPP) newI[item.first] = item.second;
             if (extensionLRU >= MIN_UTILITY && extensionSupp >= MIN_SUPP) {
-                newI[item.first] = item.second;
-                std::shared_ptr<Pattern> extendedPattern = construct_i_ext(pattern, item.second, sequences);
-                newIList[item.first] = extendedPattern;
-                if (extendedPattern->SE == pattern->SE) do_s_ext = false;                
+                newI.push_back(itemIdx);
+                newIInstances.push_back(extensionInstances);
+                if (extensionSE == pattern.SE) do_s_ext = false;
             }
+            else ++stats.local().prunedByExtension;
         }
     }
-    // for (auto item : newI) {
-    //     Pattern extendedPattern = construct_i_ext(pattern, item.second, sequences);
-    //     newIList[item.first] = extendedPattern;
-    //     if (extendedPattern.SE == pattern.SE) do_s_ext = false;
-    // }
+    if (!do_s_ext) ++stats.local().skippedBySE;
     if (do_s_ext) {
-        for (auto item : S) {
-            float extensionLRU = 0;
+        for (auto itemIdx : S) {
+            ++stats.local().candidates;
+            if (patternBits.commonSupport(context.itemBits[itemIdx]) < MIN_SUPP) {
+                ThreadStats &local = stats.local();
+                ++local.rejectedByBitmap;
+                ++local.prunedByExtension;
+                continue;
+            }
+            Utility extensionLRU = 0;
             unsigned int extensionSupp = 0;
-            std::unordered_set<int> commonSeqs;
-            for (auto seq : item.second->siduls) commonSeqs.insert(seq.first);
-            for (auto seq : pattern->siduls) {
-                if (commonSeqs.find(seq.first) != commonSeqs.end()) {
-                    if (item.second->siduls[seq.first].back()->position > pattern->siduls[seq.first].front()->position) {
-                        extensionLRU += (pattern->siduls[seq.first][0]->utility + pattern->siduls[seq.first][0]->rem);
+            size_t extensionInstances = 0;
+            const BasicSidul<Utility, Position, Sid> &itemSiduls = context.items[itemIdx]->siduls, &patternSiduls = pattern.siduls;
+            unsigned int patternSeqIdx = 0, itemSeqIdx = 0;
+            while (patternSeqIdx < patternSiduls.size() && itemSeqIdx < itemSiduls.size()) {
+                if (patternSiduls.sids[patternSeqIdx] < itemSiduls.sids[itemSeqIdx]) ++patternSeqIdx;
+                else if (patternSiduls.sids[patternSeqIdx] > itemSiduls.sids[itemSeqIdx]) ++itemSeqIdx;
+                else {
+                    const unsigned int first = patternSiduls.begin(patternSeqIdx);
+                    if (itemSiduls.position[itemSiduls.end(itemSeqIdx) - 1] > patternSiduls.position[first]) {
+                        extensionLRU += (patternSiduls.utility[first] + patternSiduls.rem[first]);
                         extensionSupp += 1;
+                        extensionInstances += itemSiduls.end(itemSeqIdx) - itemSiduls.begin(itemSeqIdx);
                     }
+                    ++patternSeqIdx;
+                    ++itemSeqIdx;
                 }
             }
-            if (extensionLRU >= MIN_UTILITY && extensionSupp >= MIN_SUPP) newS[item.first] = item.second;
+            if (extensionLRU >= MIN_UTILITY && extensionSupp >= MIN_SUPP) {
+                newS.push_back(itemIdx);
+                newSInstances.push_back(extensionInstances);
+            }
+            else ++stats.local().prunedByExtension;
         }
-        for (auto item : newS) {
-            std::shared_ptr<Pattern> extendedPattern = construct_s_ext(pattern, item.second, sequences);
-            #pragma omp task untied shared(syncTime, newS, sequences, FCHUPatterns) firstprivate(extendedPattern)
-            {
-                dfs(extendedPattern, newS, newS, MIN_SUPP, MIN_UTILITY, sequences, FCHUPatterns, syncTime);
+        for (size_t idx = 0; idx < newS.size(); ++idx) {
+            const unsigned int itemIdx = newS[idx];
+            if (cutoff.spawn(newSInstances[idx], 2 * newS.size(), depth + 1)) {
+                #pragma omp task untied shared(pattern, stats, newS, minUtility, context, FCHUPatterns, batch, cutoff) firstprivate(itemIdx, depth)
+                extend(pattern, itemIdx, true, newS, newS, MIN_SUPP, minUtility, context, FCHUPatterns, stats, batch, cutoff, tracer, traced, depth + 1, true);
+            } else extend(pattern, itemIdx, true, newS, newS, MIN_SUPP, minUtility, context, FCHUPatterns, stats, batch, cutoff, tracer, traced, depth + 1, false);
+        }
+    }
+    /*
+        Without s-extensions, the i-extensions keep the parent's candidates for their own s-extensions.
+    */
+    const std::vector<unsigned int> *childS = do_s_ext ? &newS : &S;
+    for (size_t idx = 0; idx < newI.size(); ++idx) {
+        const unsigned int itemIdx = newI[idx];
+        if (cutoff.spawn(newIInstances[idx], newI.size() + childS->size(), depth + 1)) {
+            #pragma omp task untied shared(pattern, stats, newI, minUtility, context, FCHUPatterns, batch, cutoff) firstprivate(itemIdx, childS, depth)
+            extend(pattern, itemIdx, false, newI, *childS, MIN_SUPP, minUtility, context, FCHUPatterns, stats, batch, cutoff, tracer, traced, depth + 1, true);
+        } else extend(pattern, itemIdx, false, newI, *childS, MIN_SUPP, minUtility, context, FCHUPatterns, stats, batch, cutoff, tracer, traced, depth + 1, false);
+    }
+    #pragma omp taskwait
+}
+
+/*
+    Build the extension of pattern by the itemIdx-th item of the context and search its subtree.
+    The extension lives in an arena of this frame, which is released once the subtree is over,
+    closed patterns being copied out of it by FCHUPatterns. isTask tells whether the subtree
+    runs as a task of its own, which is then traced, traced being the task it runs in otherwise.
+*/
+template <typename Utility, typename Position, typename Sid>
+void extend(
+    const BasicPattern<Utility, Position, Sid> &pattern,
+    unsigned int itemIdx,
+    bool isSExt,
+    const std::vector<unsigned int> &I,
+    const std::vector<unsigned int> &S,
+    float MIN_SUPP,
+    const UtilityThreshold<Utility> &minUtility,
+    const BasicMiningContext<Utility, Position, Sid> &context,
+    FCloStore<Utility> &FCHUPatterns,
+    SearchStats &stats,
+    const std::vector<BatchSetting<Utility>> &batch,
+    const TaskCutoff &cutoff,
+    Tracer *tracer,
+    TracedTask *traced,
+    unsigned int depth,
+    bool isTask
+) {
+    std::pmr::monotonic_buffer_resource arena(ARENA_MIN_SIZE, cutoff.resource());
+    BasicPattern<Utility, Position, Sid> extendedPattern(&arena);
+    if (isSExt) {
+        construct_s_ext(extendedPattern, pattern, *context.items[itemIdx], context);
+        ++stats.local().sExtensions;
+    } else {
+        construct_i_ext(extendedPattern, pattern, *context.items[itemIdx], context);
+        ++stats.local().iExtensions;
+    }
+    TracedTask task(isTask ? tracer : nullptr, extendedPattern, depth);
+    dfs(extendedPattern, I, S, MIN_SUPP, minUtility, context, FCHUPatterns, stats, batch, cutoff, tracer, tracer && isTask ? &task : traced, depth);
+}
+
+/*
+    The closed patterns of a store, with the original ids of their items and their utilities in
+    the units of the input. In top-k mode, only the k of highest utility are returned, in
+    descending order of utility.
+*/
+template <typename Utility>
+std::vector<FCloPattern> closed_patterns(
+    FCloStore<Utility> &store,
+    const UtilityThreshold<Utility> &minUtility,
+    double scale,
+    const std::vector<int> &originalIds
+) {
+    std::vector<const BasicFCloPattern<Utility>*> cloPatterns = store.patterns();
+    const unsigned int topK = minUtility.topK();
+    if (topK) {
+        /*
+            Patterns stored before the threshold reached its final value may fall below it
+        */
+        const Utility threshold = minUtility.get();
+        cloPatterns.erase(
+            std::remove_if(cloPatterns.begin(), cloPatterns.end(), [&](const BasicFCloPattern<Utility> *it) { return it->umin < threshold; }),
+            cloPatterns.end()
+        );
+    }
+    std::vector<BasicFCloPattern<Utility>> restoredPatterns;
+    if (!originalIds.empty()) {
+        /*
+            Patterns are output with the original ids of their items, which also break ties
+            between the top k
+        */
+        restoredPatterns.reserve(cloPatterns.size());
+        for (auto &pattern : cloPatterns) {
+            restoredPatterns.push_back(*pattern);
+            restoredPatterns.back().items = restore_items(pattern->items, originalIds);
+        }
+        for (size_t idx = 0; idx < cloPatterns.size(); ++idx) cloPatterns[idx] = &restoredPatterns[idx];
+    }
+    if (topK) {
+        std::sort(cloPatterns.begin(), cloPatterns.end(), [](const BasicFCloPattern<Utility> *a, const BasicFCloPattern<Utility> *b) {
+            return a->umin > b->umin || (a->umin == b->umin && a->items < b->items);
+        });
+        if (cloPatterns.size() > topK) cloPatterns.resize(topK);
+    }
+
+    std::vector<FCloPattern> patterns(cloPatterns.size());
+    for (size_t idx = 0; idx < cloPatterns.size(); ++idx) {
+        const BasicFCloPattern<Utility> &pattern = *cloPatterns[idx];
+        patterns[idx].items.assign(pattern.items.begin(), pattern.items.end());
+        patterns[idx].size = pattern.size;
+        patterns[idx].support = pattern.support;
+        patterns[idx].umin = from_fixed(pattern.umin, scale);
+        patterns[idx].SE = pattern.SE;
+        patterns[idx].SLIP = pattern.SLIP;
+    }
+    return patterns;
+}
+
+/*
+    Search the context once for all the settings and return the closed patterns of each one.
+    The search runs with the loosest support and utility among them, which the context was
+    pruned with, and every pattern it meets is checked against the closed set of each setting
+    it qualifies for. A pattern subsumed with the same SE and SLIP has its extensions subsumed
+    too, whatever the thresholds, so the pruning rules of the loosest closed set hold for all.
+*/
+template <typename Utility, typename Position, typename Sid>
+std::vector<std::vector<FCloPattern>> mine(
+    const BasicMiningContext<Utility, Position, Sid> &context,
+    double scale,
+    const std::vector<Thresholds> &settings,
+    unsigned int topK,
+    unsigned int numSequences,
+    const Partition &partition,
+    bool isPartitioned,
+    const std::vector<int> &originalIds,
+    const TaskCutoff &cutoff,
+    const CheckpointRun &checkpointRun,
+    SearchStats &stats,
+    Tracer *tracer
+) {
+    std::vector<unsigned int> items(context.items.size());
+    std::iota(items.begin(), items.end(), 0);
+
+    float MIN_SUPP = settings[0].minSupport, MIN_UTIL = settings[0].minUtility;
+    for (auto &setting : settings) {
+        MIN_SUPP = std::min(MIN_SUPP, setting.minSupport);
+        MIN_UTIL = std::min(MIN_UTIL, setting.minUtility);
+    }
+    UtilityThreshold<Utility> minUtility(to_threshold<Utility>(MIN_UTIL, scale), topK);
+    FCloStore<Utility> FCHUPatterns(numSequences, minUtility);
+    /*
+        Settings with the same thresholds share a closed set, the loosest one being the store
+        searched
+    */
+    std::vector<std::unique_ptr<UtilityThreshold<Utility>>> batchThresholds;
+    std::vector<std::unique_ptr<FCloStore<Utility>>> batchStores;
+    std::vector<BatchSetting<Utility>> batch;
+    std::vector<FCloStore<Utility>*> settingStores;
+    std::vector<const UtilityThreshold<Utility>*> settingThresholds;
+    for (auto &setting : settings) {
+        const Utility settingUtility = to_threshold<Utility>(setting.minUtility, scale);
+        FCloStore<Utility> *store = nullptr;
+        const UtilityThreshold<Utility> *threshold = &minUtility;
+        if (setting.minSupport == MIN_SUPP && settingUtility == minUtility.get()) store = &FCHUPatterns;
+        for (size_t idx = 0; !store && idx < batch.size(); ++idx)
+            if (batch[idx].minSupport == setting.minSupport && batch[idx].minUtility == settingUtility) {
+                store = batch[idx].store;
+                threshold = batchThresholds[idx].get();
             }
-        // #pragma omp taskwait
+        if (!store) {
+            batchThresholds.emplace_back(new UtilityThreshold<Utility>(settingUtility, 0));
+            batchStores.emplace_back(new FCloStore<Utility>(numSequences, *batchThresholds.back()));
+            store = batchStores.back().get();
+            threshold = batchThresholds.back().get();
+            batch.push_back({setting.minSupport, settingUtility, store});
         }
-    } else newS = S;
-    for (auto extendedPattern : newIList) 
-        #pragma omp task untied shared(syncTime, newI, newS, sequences, FCHUPatterns) firstprivate(extendedPattern)
+        settingStores.push_back(store);
+        settingThresholds.push_back(threshold);
+    }
+    std::vector<unsigned int> partitions;
+    if (isPartitioned) partitions = partition_items(context, partition.count);
+    /*
+        Every item of the context is the root of a subtree, whose end is recorded once its
+        last task is over. The closed sets of the batch follow the one searched.
+    */
+    std::unique_ptr<CheckpointWriter<Utility>> checkpoints;
+    if (!checkpointRun.path.empty()) {
+        std::vector<int> rootIds;
+        for (auto &item : context.items) rootIds.push_back(item->lastItem);
+        std::vector<FCloStore<Utility>*> stores(1, &FCHUPatterns);
+        for (auto &setting : batch) stores.push_back(setting.store);
+        checkpoints.reset(new CheckpointWriter<Utility>(checkpointRun, rootIds, stores));
+        if (checkpointRun.isResumed) stats.resumedRoots = checkpoints->resume();
+        checkpoints->start();
+    }
+    CheckpointWriter<Utility> *writer = checkpoints.get();
+
+    double phaseStart = omp_get_wtime();
+    #pragma omp parallel default(none) shared(stats, context, items, FCHUPatterns, MIN_SUPP, minUtility, batch, cutoff, tracer, partitions, partition, writer)
+    {
+        #pragma omp single
         {
-            dfs(extendedPattern.second, newI, newS, MIN_SUPP, MIN_UTILITY, sequences, FCHUPatterns, syncTime);
+            for (unsigned int itemIdx = 0; itemIdx < context.items.size(); ++itemIdx) {
+                if (!partitions.empty() && partitions[itemIdx] != partition.index) continue;
+                if (writer && writer->isOver(itemIdx)) continue;
+                std::shared_ptr<BasicPattern<Utility, Position, Sid>> pattern = context.items[itemIdx];
+                if (cutoff.spawn(pattern->siduls.utility.size(), 2 * items.size(), 0)) {
+                    #pragma omp task untied default(none) shared(stats, FCHUPatterns, context, items, MIN_SUPP, minUtility, batch, cutoff) firstprivate(pattern, tracer, writer, itemIdx)
+                    {
+                        TracedTask traced(tracer, *pattern, 0);
+                        dfs(*pattern, items, items, MIN_SUPP, minUtility, context, FCHUPatterns, stats, batch, cutoff, tracer, tracer ? &traced : nullptr, 0);
+                        if (writer) writer->finish(itemIdx);
+                    }
+                } else {
+                    dfs(*pattern, items, items, MIN_SUPP, minUtility, context, FCHUPatterns, stats, batch, cutoff, tracer, nullptr, 0);
+                    if (writer) writer->finish(itemIdx);
+                }
+            }
+            #pragma omp taskwait
         }
-    #pragma omp taskwait
+    }
+    stats.phases.search = omp_get_wtime() - phaseStart;
+    if (tracer) tracer->phase("search", phaseStart);
+    if (writer) stats.checkpoints = writer->stop();
+
+    phaseStart = omp_get_wtime();
+    std::vector<std::vector<FCloPattern>> patterns;
+    for (size_t idx = 0; idx < settings.size(); ++idx)
+        patterns.push_back(closed_patterns(*settingStores[idx], *settingThresholds[idx], scale, originalIds));
+    stats.phases.output = omp_get_wtime() - phaseStart;
+    return patterns;
+}
+
+/*
+    Parse "S:U[,S:U...]", the MIN_SUPP and MIN_UTIL of each setting
+*/
+static bool parseBatch(const std::string &value, std::vector<Thresholds> &settings) {
+    size_t begin = 0;
+    while (begin <= value.size()) {
+        size_t end = value.find(',', begin);
+        if (end == std::string::npos) end = value.size();
+        const std::string setting = value.substr(begin, end - begin);
+        const size_t colon = setting.find(':');
+        if (colon == std::string::npos) return false;
+        size_t supportEnd = 0, utilityEnd = 0;
+        try {
+            const float minSupport = std::stof(setting.substr(0, colon), &supportEnd);
+            const float minUtility = std::stof(setting.substr(colon + 1), &utilityEnd);
+            settings.push_back({minSupport, minUtility});
+        } catch (const std::exception&) {
+            return false;
+        }
+        if (supportEnd != colon || utilityEnd != setting.size() - colon - 1) return false;
+        begin = end + 1;
+    }
+    return true;
+}
+
+int usage(const char *program) {
+    std::cerr << "Usage: " << program << " MIN_SUPP MIN_UTIL INPUT_DATA_PATH [OPTIONS]" << std::endl <<
+    "  --threads N       number of threads, all cores by default" << std::endl <<
+    "  --task-depth D    extensions less than D levels below an item always run as tasks (2)" << std::endl <<
+    "  --task-cutoff W   deeper ones only when SIDUL instances x candidates >= W (65536)" << std::endl <<
+    "  --top-k K         only output the K closed patterns of highest utility, MIN_UTIL being a floor" << std::endl <<
+    "  --stats           write counters and timings of the run as JSON to stderr" << std::endl <<
+    "  --trace FILE      write a timeline of the search tasks to FILE, in the Chrome trace-event format" << std::endl <<
+    "  --save-state FILE keep what incremental mining needs from this run in FILE" << std::endl <<
+    "  --incremental FILE  INPUT_DATA_PATH only holds the sequences appended since the run saved in FILE" << std::endl <<
+    "  --index           reuse the preprocessed index next to INPUT_DATA_PATH, building it when missing or stale" << std::endl <<
+    "  --partition I/N   only mine the I-th of N partitions of the search, from 0, to be merged with merge" << std::endl <<
+    "  --processes N     run the N partitions as processes sharing the threads, and merge them" << std::endl <<
+    "  --mem-limit MB    run subtrees inline instead of as tasks once the search holds nearly MB megabytes" << std::endl <<
+    "  --batch S:U[,S:U...]  also output the closed patterns of these MIN_SUPP:MIN_UTIL settings, from the same search" << std::endl <<
+    "  --checkpoint FILE keep the subtrees over and their closed patterns in FILE as the search goes" << std::endl <<
+    "  --checkpoint-interval S  seconds between two checkpoints (" << CHECKPOINT_INTERVAL << ")" << std::endl <<
+    "  --resume          skip the subtrees over in the checkpoint FILE and start from its closed patterns" << std::endl;
+    return 1;
 }
 
 int main(int argvc, char** argv) {
-    const float MIN_SUPP = std::stof(argv[1]);
-    const float MIN_UTILITY = std::stof(argv[2]);
+    if (argvc < 4) return usage(argv[0]);
+    std::vector<Thresholds> settings(1, {std::stof(argv[1]), std::stof(argv[2])});
     const std::string INPUT_DATA_PATH = argv[3];
 
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences = readInputData(INPUT_DATA_PATH);
+    TaskCutoff cutoff;
+    unsigned int topK = 0, processes = 1;
+    size_t memoryLimit = 0;
+    Partition partition;
+    bool isPartitioned = false;
+    bool printStats = false, withIndex = false;
+    std::string tracePath, statePath, saveStatePath;
+    CheckpointRun checkpointRun;
+    bool hasInterval = false;
+    for (int arg = 4; arg < argvc; ++arg) {
+        const std::string option = argv[arg];
+        if (option == "--stats") {
+            printStats = true;
+            continue;
+        }
+        if (option == "--index") {
+            withIndex = true;
+            continue;
+        }
+        if (option == "--resume") {
+            checkpointRun.isResumed = true;
+            continue;
+        }
+        if (arg + 1 == argvc) return usage(argv[0]);
+        if (option == "--trace") {
+            tracePath = argv[++arg];
+            continue;
+        }
+        if (option == "--incremental") {
+            statePath = argv[++arg];
+            continue;
+        }
+        if (option == "--save-state") {
+            saveStatePath = argv[++arg];
+            continue;
+        }
+        if (option == "--checkpoint") {
+            checkpointRun.path = argv[++arg];
+            continue;
+        }
+        if (option == "--batch") {
+            if (!parseBatch(argv[++arg], settings)) return usage(argv[0]);
+            continue;
+        }
+        if (option == "--partition") {
+            if (!parsePartition(argv[++arg], partition)) return usage(argv[0]);
+            isPartitioned = true;
+            continue;
+        }
+        const unsigned long value = std::stoul(argv[++arg]);
+        if (option == "--threads" && value > 0) {
+            omp_set_num_threads(value);
+            cutoff.threads = value;
+        }
+        else if (option == "--task-depth") cutoff.depth = value;
+        else if (option == "--task-cutoff") cutoff.minWork = value;
+        else if (option == "--top-k" && value > 0) topK = value;
+        else if (option == "--processes" && value > 0) processes = value;
+        else if (option == "--mem-limit" && value > 0) memoryLimit = value;
+        else if (option == "--checkpoint-interval" && value > 0) {
+            checkpointRun.interval = value;
+            hasInterval = true;
+        }
+        else return usage(argv[0]);
+    }
+    /*
+        The state keeps the whole closed set, which top-k mode does not output
+    */
+    if (topK && (!statePath.empty() || !saveStatePath.empty())) return usage(argv[0]);
+    /*
+        Nor does the index hold the sequences the state is made of
+    */
+    if (withIndex && (!statePath.empty() || !saveStatePath.empty())) return usage(argv[0]);
+    /*
+        Partitions only keep the patterns closed within their own share of the search, which
+        leaves neither a top k nor a closed set to save. Processes share a single trace file.
+    */
+    if ((isPartitioned || processes > 1) && (topK || !statePath.empty() || !saveStatePath.empty())) return usage(argv[0]);
+    if (processes > 1 && (isPartitioned || !tracePath.empty())) return usage(argv[0]);
     /*
-        Scan the database to compute all SIDULs for all items
+        A batch outputs the whole closed set of each setting, and has no single one to save
+        or to split
     */
-    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> sidulItems = construct_siduls(sequences);
+    const bool isBatch = settings.size() > 1;
+    if (isBatch && (topK || isPartitioned || processes > 1 || !statePath.empty() || !saveStatePath.empty())) return usage(argv[0]);
     /*
-        Remove items whose supp < MIN_SUPP || LRU < MIN_UTILITY
+        A checkpoint is tied to the hash of the input data alone, which leaves out the state an
+        incremental run appends it to, and processes would share its file
     */
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> updatedSequences = WPS_by_LRU_and_Support(sequences, sidulItems, MIN_SUPP, MIN_UTILITY);
+    if (checkpointRun.path.empty() && (checkpointRun.isResumed || hasInterval)) return usage(argv[0]);
+    if (!checkpointRun.path.empty() && (!statePath.empty() || processes > 1)) return usage(argv[0]);
     /*
-        Re-construct the siduls with the recently updated sequences
+        The database is pruned with the loosest thresholds of the batch, which the search runs with
     */
-    sidulItems = construct_siduls(updatedSequences);
+    float MIN_SUPP = settings[0].minSupport, MIN_UTILITY = settings[0].minUtility;
+    for (auto &setting : settings) {
+        MIN_SUPP = std::min(MIN_SUPP, setting.minSupport);
+        MIN_UTILITY = std::min(MIN_UTILITY, setting.minUtility);
+    }
 
-    std::unordered_map<unsigned int, FCloSublist> FCHUPatterns;
+    if (processes > 1) {
+        /*
+            The partitions get the same arguments, with a share of the threads and of the memory
+            limit each
+        */
+        std::vector<std::string> arguments(argv, argv + 4);
+        for (int arg = 4; arg < argvc; ++arg) {
+            const std::string option = argv[arg];
+            if (option == "--processes" || option == "--threads" || option == "--mem-limit") ++arg;
+            else arguments.push_back(option);
+        }
+        arguments.push_back("--threads");
+        arguments.push_back(std::to_string(std::max(1u, cutoff.threads / processes)));
+        if (memoryLimit) {
+            arguments.push_back("--mem-limit");
+            arguments.push_back(std::to_string(std::max<size_t>(1, memoryLimit / processes)));
+        }
+        try {
+            writeMergedOutput(run_partitions(arguments, processes), std::cout);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    std::cout << "# items: " << sidulItems.size() << ", # sequences: " << updatedSequences.size() << std::endl;
+    SearchStats stats(omp_get_max_threads());
+    std::unique_ptr<MemoryBudget> budget;
+    if (memoryLimit) budget.reset(new MemoryBudget(memoryLimit << 20));
+    cutoff.memory = budget.get();
+    std::unique_ptr<Tracer> traceBuffers;
+    if (!tracePath.empty()) traceBuffers.reset(new Tracer(omp_get_max_threads()));
+    Tracer *tracer = traceBuffers.get();
+    /*
+        Scan the database to compute all SIDULs for all items while it is loaded
+    */
+    double phaseStart = omp_get_wtime();
+    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> loadedItems;
+    Database database;
+    Index index;
+    bool isIndexed = false;
+    if (withIndex || !checkpointRun.path.empty()) checkpointRun.hash = hashInputData(INPUT_DATA_PATH);
+    if (withIndex) {
+        const uint64_t hash = checkpointRun.hash;
+        isIndexed = readIndex(indexPath(INPUT_DATA_PATH), hash, index);
+        if (!isIndexed) {
+            database = readInputData(INPUT_DATA_PATH, loadedItems);
+            writeIndex(database, loadedItems, hash, indexPath(INPUT_DATA_PATH));
+        }
+    } else database = readInputData(INPUT_DATA_PATH, loadedItems);
+    MiningState state;
+    if (!statePath.empty()) {
+        state = readState(statePath);
+        if (state.minSupport != MIN_SUPP || state.minUtility != MIN_UTILITY) {
+            std::cerr << statePath << " was mined with MIN_SUPP=" << state.minSupport << " and MIN_UTIL=" << state.minUtility << std::endl;
+            return 1;
+        }
+    }
+    stats.phases.load = omp_get_wtime() - phaseStart;
+    if (tracer) tracer->phase("load", phaseStart);
 
-    float synTime = 0;
+    MiningContext context;
+    std::vector<FCloPattern> unaffectedPatterns;
+    std::vector<int> originalIds;
+    unsigned int numItems, numSequences;
+    if (!statePath.empty()) {
+        /*
+            The loaded sequences are appended to those of the previous run
+        */
+        phaseStart = omp_get_wtime();
+        const unsigned int firstSid = state.sequenceSizes.size();
+        unaffectedPatterns = unaffected_patterns(state, database, loadedItems);
+        append_delta(state, database, loadedItems);
+        stats.phases.constructSiduls = omp_get_wtime() - phaseStart;
+        if (tracer) tracer->phase("construct_siduls", phaseStart);
 
-    // omp_set_num_threads(2);
+        phaseStart = omp_get_wtime();
+        context = construct_context(state, loadedItems, firstSid, MIN_SUPP, MIN_UTILITY, numItems, numSequences);
+        stats.phases.context = omp_get_wtime() - phaseStart;
+        if (tracer) tracer->phase("context", phaseStart);
+    } else if (isIndexed) {
+        /*
+            The index is pruned directly, which also yields the SIDULs over the pruned sequences
+        */
+        phaseStart = omp_get_wtime();
+        std::vector<unsigned int> sequenceSizes;
+        std::unordered_map<unsigned int, std::shared_ptr<Pattern>> sidulItems =
+            shrink_database(index, MIN_SUPP, MIN_UTILITY, sequenceSizes, numSequences, originalIds);
+        stats.phases.wps = omp_get_wtime() - phaseStart;
+        if (tracer) tracer->phase("wps", phaseStart);
 
-    #pragma omp parallel default(none) shared(synTime, sidulItems, FCHUPatterns, updatedSequences, MIN_SUPP, MIN_UTILITY)
-    {
-        #pragma omp single
-        {
-            for (auto pattern : sidulItems)
-                #pragma omp task untied default(none) shared(synTime, FCHUPatterns, sidulItems, updatedSequences, MIN_SUPP, MIN_UTILITY) firstprivate(pattern)
-                {
-                    dfs(pattern.second, sidulItems, sidulItems, MIN_SUPP, MIN_UTILITY, updatedSequences, FCHUPatterns, synTime);
-                }
-            #pragma omp taskwait
+        phaseStart = omp_get_wtime();
+        numItems = sidulItems.size();
+        std::vector<std::shared_ptr<Pattern>> items;
+        for (auto &item : sidulItems) items.push_back(item.second);
+        context = construct_context(std::move(sequenceSizes), std::move(items));
+        stats.phases.context = omp_get_wtime() - phaseStart;
+        if (tracer) tracer->phase("context", phaseStart);
+    } else {
+        /*
+            Remove items whose supp < MIN_SUPP || LRU < MIN_UTILITY, until none is left to remove,
+            and renumber the others
+        */
+        phaseStart = omp_get_wtime();
+        Database updatedDatabase = shrink_database(database, loadedItems, MIN_SUPP, MIN_UTILITY, originalIds);
+        stats.phases.wps = omp_get_wtime() - phaseStart;
+        if (tracer) tracer->phase("wps", phaseStart);
+        /*
+            Re-construct the siduls with the recently updated sequences
+        */
+        phaseStart = omp_get_wtime();
+        std::unordered_map<unsigned int, std::shared_ptr<Pattern>> sidulItems = construct_siduls(updatedDatabase);
+        stats.phases.constructSiduls = omp_get_wtime() - phaseStart;
+        if (tracer) tracer->phase("construct_siduls", phaseStart);
+
+        phaseStart = omp_get_wtime();
+        context = construct_context(updatedDatabase, sidulItems);
+        stats.phases.context = omp_get_wtime() - phaseStart;
+        if (tracer) tracer->phase("context", phaseStart);
+        numItems = sidulItems.size();
+        numSequences = updatedDatabase.numSequences();
+
+        if (!saveStatePath.empty()) {
+            state.minSupport = MIN_SUPP;
+            state.minUtility = MIN_UTILITY;
+            for (auto &sequence : database.sequences) {
+                state.sequenceUtilities.push_back(sequence.utility);
+                state.sequenceSizes.push_back(sequence.size);
+            }
+            state.items = std::move(loadedItems);
         }
     }
+    if (tracer) tracer->originalIds = originalIds;
+    std::cout << "# items: " << numItems << ", # sequences: " << numSequences << std::endl;
+    if (isPartitioned) std::cout << "# partition: " << partition.index << "/" << partition.count << std::endl;
+
+    /*
+        The search runs over fixed-point utilities when the input allows it, and over the
+        narrowest positions and sequence ids holding those of the data
+    */
+    phaseStart = omp_get_wtime();
+    const SearchLayout layout = detect_layout(context);
+    stats.utility = layout.utility.name();
+    stats.utilityScale = layout.utility.scale;
+    stats.positionBits = layout.positionBits;
+    stats.sidBits = layout.sidBits;
+    stats.kernels = kernels_name(active_kernels());
+    for (auto &setting : settings) {
+        checkpointRun.thresholds.push_back(setting.minSupport);
+        checkpointRun.thresholds.push_back(setting.minUtility);
+    }
+    checkpointRun.utility = layout.utility;
+    checkpointRun.topK = topK;
+    checkpointRun.partition = partition;
+    std::vector<std::vector<FCloPattern>> minedPatterns;
+    auto search = [&](auto utility, auto position, auto sid) {
+        using Utility = decltype(utility);
+        using Position = decltype(position);
+        using Sid = decltype(sid);
+        if constexpr (std::is_same<BasicMiningContext<Utility, Position, Sid>, MiningContext>::value) {
+            stats.phases.context += omp_get_wtime() - phaseStart;
+            minedPatterns = mine(context, layout.utility.scale, settings, topK, numSequences, partition, isPartitioned, originalIds, cutoff, checkpointRun, stats, tracer);
+        } else {
+            const BasicMiningContext<Utility, Position, Sid> searchContext = to_layout<Utility, Position, Sid>(context, layout.utility.scale);
+            context = MiningContext();
+            stats.phases.context += omp_get_wtime() - phaseStart;
+            if (tracer) tracer->phase("layout", phaseStart);
+            minedPatterns = mine(searchContext, layout.utility.scale, settings, topK, numSequences, partition, isPartitioned, originalIds, cutoff, checkpointRun, stats, tracer);
+        }
+    };
+    auto searchSids = [&](auto utility, auto position) {
+        if (layout.sidBits == 16) search(utility, position, uint16_t());
+        else search(utility, position, uint32_t());
+    };
+    auto searchPositions = [&](auto utility) {
+        if (layout.positionBits == 16) searchSids(utility, uint16_t());
+        else searchSids(utility, uint32_t());
+    };
+    if (layout.utility.type == UtilityType::INT32) searchPositions(int32_t());
+    else if (layout.utility.type == UtilityType::INT64) searchPositions(int64_t());
+    else searchPositions(float());
 
-    int numOfPattern = 0;
-    for (auto it : FCHUPatterns) {
-        numOfPattern += it.second.cloPatterns.size();
-        for (auto ii : it.second.cloPatterns)
-            std::cout << ii->name << 
-            ", supp=" << ii->siduls.size() << 
+    phaseStart = omp_get_wtime();
+    std::vector<const FCloPattern*> cloPatterns;
+    for (size_t idx = 0; idx < settings.size(); ++idx) {
+        cloPatterns.clear();
+        for (auto &pattern : minedPatterns[idx]) cloPatterns.push_back(&pattern);
+        for (auto &pattern : unaffectedPatterns) cloPatterns.push_back(&pattern);
+
+        if (isBatch) std::cout << "# setting: " << settings[idx].minSupport << " " << settings[idx].minUtility << std::endl;
+        int numOfPattern = 0;
+        for (auto ii : cloPatterns) {
+            ++numOfPattern;
+            std::cout << pattern_to_string(ii->items) << 
+            ", supp=" << ii->support << 
             ", utility=" << ii->umin <<
             std::endl;
+        }
+        std::cout << "Total: " << numOfPattern << std::endl;
+    }
+    stats.phases.output += omp_get_wtime() - phaseStart;
+    if (tracer) tracer->phase("output", phaseStart);
+
+    if (!saveStatePath.empty()) {
+        state.patterns.clear();
+        for (auto ii : cloPatterns) state.patterns.push_back(*ii);
+        writeState(state, saveStatePath);
+    }
+
+    if (budget) {
+        stats.memoryLimit = budget->limit();
+        stats.memoryPeak = budget->peak();
     }
-    std::cout << "Total: " << numOfPattern << std::endl;
+    if (printStats) stats.writeJSON(std::cerr);
+    if (tracer) tracer->write(tracePath);
 
-    // std::cout << "SynTime: " << synTime << std::endl;
-    
     return 0;
 }
@@ -0,0 +1,35 @@
+/*
+    Merge the outputs of the partitions of a run, written with --partition, into the output
+    of the full run.
+
+        $ merge PARTITION_OUTPUT...
+
+    Every partition of the run must be given once, in any order.
+*/
+#include "partition.h"
+#include "utils.h"
+
+int main(int argvc, char** argv) {
+    if (argvc < 2) {
+        std::cerr << "Usage: " << argv[0] << " PARTITION_OUTPUT..." << std::endl;
+        return 1;
+    }
+
+    std::vector<PartitionOutput> outputs;
+    try {
+        for (int arg = 1; arg < argvc; ++arg) {
+            std::ifstream in(argv[arg]);
+            if (!in) {
+                std::cerr << "Cannot read " << argv[arg] << std::endl;
+                return 1;
+            }
+            outputs.push_back(readPartitionOutput(in, argv[arg]));
+        }
+        writeMergedOutput(outputs, std::cout);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <immintrin.h>
+#include "metrics.h"
+
+/*
+    Offsets and sequence ids are used as signed 32-bit gather indices, a SIDUL never holds
+    anywhere near 2^31 instances
+*/
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+KernelSet detect_kernels() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return KernelSet::AVX512;
+    if (__builtin_cpu_supports("avx2")) return KernelSet::AVX2;
+    return KernelSet::SCALAR;
+}
+
+KernelSet active_kernels() {
+    static const KernelSet kernels = detect_kernels();
+    return kernels;
+}
+
+std::string kernels_name(KernelSet kernels) {
+    switch (kernels) {
+        case KernelSet::AVX512: return "avx512";
+        case KernelSet::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+template <typename Utility>
+static Utility minimumScalar(const Utility *utility, unsigned int begin, unsigned int end) {
+    Utility minimum = utility[begin];
+    for (unsigned int instance = begin + 1; instance < end; ++instance) minimum = std::min(minimum, utility[instance]);
+    return minimum;
+}
+
+template <typename Utility>
+static Utility sumMinimaScalar(const Utility *utility, const unsigned int *offsets, size_t count) {
+    Utility total = 0;
+    for (size_t idx = 0; idx < count; ++idx) total += minimumScalar(utility, offsets[idx], offsets[idx + 1]);
+    return total;
+}
+
+template <typename Utility>
+static Utility sumFirstsScalar(const Utility *utility, const Utility *rem, const unsigned int *offsets, size_t count) {
+    Utility total = 0;
+    for (size_t idx = 0; idx < count; ++idx) total += utility[offsets[idx]] + rem[offsets[idx]];
+    return total;
+}
+
+template <typename Position, typename Sid>
+static unsigned int sumExtentsScalar(
+    const Position *position,
+    const Sid *sids,
+    const unsigned int *offsets,
+    const unsigned int *sequenceSizes,
+    size_t count
+) {
+    unsigned int total = 0;
+    for (size_t idx = 0; idx < count; ++idx) total += sequenceSizes[sids[idx]] - position[offsets[idx]];
+    return total;
+}
+
+/*
+    The last vector of a sequence overlaps the previous one when its instances are not a
+    multiple of the lanes, which a minimum does not mind. Shorter sequences are left scalar.
+*/
+template <typename Utility>
+TARGET_AVX2 static Utility minimumAvx2(const Utility *utility, unsigned int begin, unsigned int end) {
+    constexpr unsigned int LANES = 32 / sizeof(Utility);
+    if (end - begin < LANES) return minimumScalar(utility, begin, end);
+    Utility lanes[LANES];
+    if constexpr (std::is_floating_point<Utility>::value) {
+        __m256 minimum = _mm256_loadu_ps(utility + begin);
+        for (unsigned int instance = begin + LANES; instance < end; instance += LANES)
+            minimum = _mm256_min_ps(minimum, _mm256_loadu_ps(utility + std::min(instance, end - LANES)));
+        _mm256_storeu_ps(lanes, minimum);
+    } else {
+        __m256i minimum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(utility + begin));
+        for (unsigned int instance = begin + LANES; instance < end; instance += LANES) {
+            const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(utility + std::min(instance, end - LANES)));
+            if constexpr (sizeof(Utility) == 4) minimum = _mm256_min_epi32(minimum, next);
+            else minimum = _mm256_blendv_epi8(minimum, next, _mm256_cmpgt_epi64(minimum, next));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), minimum);
+    }
+    return *std::min_element(lanes, lanes + LANES);
+}
+
+template <typename Utility>
+TARGET_AVX2 static Utility sumMinimaAvx2(const Utility *utility, const unsigned int *offsets, size_t count) {
+    Utility total = 0;
+    for (size_t idx = 0; idx < count; ++idx) total += minimumAvx2(utility, offsets[idx], offsets[idx + 1]);
+    return total;
+}
+
+/*
+    Float lanes are added one by one in the order of the sequences, integer ones in any order
+*/
+template <typename Utility>
+TARGET_AVX2 static Utility sumFirstsAvx2(const Utility *utility, const Utility *rem, const unsigned int *offsets, size_t count) {
+    Utility total = 0;
+    size_t idx = 0;
+    if constexpr (std::is_floating_point<Utility>::value) {
+        for (; idx + 8 <= count; idx += 8) {
+            const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + idx));
+            float lanes[8];
+            _mm256_storeu_ps(lanes, _mm256_add_ps(_mm256_i32gather_ps(utility, first, 4), _mm256_i32gather_ps(rem, first, 4)));
+            for (auto lane : lanes) total += lane;
+        }
+    } else if constexpr (sizeof(Utility) == 4) {
+        __m256i sum = _mm256_setzero_si256();
+        for (; idx + 8 <= count; idx += 8) {
+            const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + idx));
+            sum = _mm256_add_epi32(sum, _mm256_add_epi32(
+                _mm256_i32gather_epi32(reinterpret_cast<const int*>(utility), first, 4),
+                _mm256_i32gather_epi32(reinterpret_cast<const int*>(rem), first, 4)
+            ));
+        }
+        Utility lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+        for (auto lane : lanes) total += lane;
+    } else {
+        __m256i sum = _mm256_setzero_si256();
+        for (; idx + 4 <= count; idx += 4) {
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets + idx));
+            sum = _mm256_add_epi64(sum, _mm256_add_epi64(
+                _mm256_i32gather_epi64(reinterpret_cast<const long long*>(utility), first, 8),
+                _mm256_i32gather_epi64(reinterpret_cast<const long long*>(rem), first, 8)
+            ));
+        }
+        Utility lanes[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+        for (auto lane : lanes) total += lane;
+    }
+    for (; idx < count; ++idx) total += utility[offsets[idx]] + rem[offsets[idx]];
+    return total;
+}
+
+/*
+    16-bit positions are gathered as 32-bit words and masked. The word read for the first
+    instance of a sequence ends with the next instance, which exists as long as a later
+    sequence follows, so the last sequence is left to the scalar tail.
+*/
+template <typename Position, typename Sid>
+TARGET_AVX2 static unsigned int sumExtentsAvx2(
+    const Position *position,
+    const Sid *sids,
+    const unsigned int *offsets,
+    const unsigned int *sequenceSizes,
+    size_t count
+) {
+    const size_t vectorEnd = sizeof(Position) == 2 && count ? count - 1 : count;
+    __m256i sum = _mm256_setzero_si256();
+    size_t idx = 0;
+    for (; idx + 8 <= vectorEnd; idx += 8) {
+        const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + idx));
+        __m256i sid, firstPosition;
+        if constexpr (sizeof(Sid) == 2) sid = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sids + idx)));
+        else sid = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sids + idx));
+        if constexpr (sizeof(Position) == 2)
+            firstPosition = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(position), first, 2), _mm256_set1_epi32(0xffff));
+        else firstPosition = _mm256_i32gather_epi32(reinterpret_cast<const int*>(position), first, 4);
+        sum = _mm256_add_epi32(sum, _mm256_sub_epi32(_mm256_i32gather_epi32(reinterpret_cast<const int*>(sequenceSizes), sid, 4), firstPosition));
+    }
+    unsigned int lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+    unsigned int total = 0;
+    for (auto lane : lanes) total += lane;
+    for (; idx < count; ++idx) total += sequenceSizes[sids[idx]] - position[offsets[idx]];
+    return total;
+}
+
+/*
+    Sequences with fewer instances than lanes are loaded under a mask, the other lanes holding
+    the largest utility
+*/
+template <typename Utility>
+TARGET_AVX512 static Utility minimumAvx512(const Utility *utility, unsigned int begin, unsigned int end) {
+    constexpr unsigned int LANES = 64 / sizeof(Utility);
+    const unsigned int length = end - begin;
+    if (length == 1) return utility[begin];
+    if constexpr (std::is_floating_point<Utility>::value) {
+        __m512 minimum;
+        if (length < LANES) minimum = _mm512_mask_loadu_ps(_mm512_set1_ps(std::numeric_limits<float>::max()), (__mmask16)((1u << length) - 1), utility + begin);
+        else {
+            minimum = _mm512_loadu_ps(utility + begin);
+            for (unsigned int instance = begin + LANES; instance < end; instance += LANES)
+                minimum = _mm512_min_ps(minimum, _mm512_loadu_ps(utility + std::min(instance, end - LANES)));
+        }
+        return _mm512_reduce_min_ps(minimum);
+    } else if constexpr (sizeof(Utility) == 4) {
+        __m512i minimum;
+        if (length < LANES) minimum = _mm512_mask_loadu_epi32(_mm512_set1_epi32(std::numeric_limits<int32_t>::max()), (__mmask16)((1u << length) - 1), utility + begin);
+        else {
+            minimum = _mm512_loadu_si512(utility + begin);
+            for (unsigned int instance = begin + LANES; instance < end; instance += LANES)
+                minimum = _mm512_min_epi32(minimum, _mm512_loadu_si512(utility + std::min(instance, end - LANES)));
+        }
+        return _mm512_reduce_min_epi32(minimum);
+    } else {
+        __m512i minimum;
+        if (length < LANES) minimum = _mm512_mask_loadu_epi64(_mm512_set1_epi64(std::numeric_limits<int64_t>::max()), (__mmask8)((1u << length) - 1), utility + begin);
+        else {
+            minimum = _mm512_loadu_si512(utility + begin);
+            for (unsigned int instance = begin + LANES; instance < end; instance += LANES)
+                minimum = _mm512_min_epi64(minimum, _mm512_loadu_si512(utility + std::min(instance, end - LANES)));
+        }
+        return _mm512_reduce_min_epi64(minimum);
+    }
+}
+
+template <typename Utility>
+TARGET_AVX512 static Utility sumMinimaAvx512(const Utility *utility, const unsigned int *offsets, size_t count) {
+    Utility total = 0;
+    for (size_t idx = 0; idx < count; ++idx) total += minimumAvx512(utility, offsets[idx], offsets[idx + 1]);
+    return total;
+}
+
+template <typename Utility>
+TARGET_AVX512 static Utility sumFirstsAvx512(const Utility *utility, const Utility *rem, const unsigned int *offsets, size_t count) {
+    Utility total = 0;
+    size_t idx = 0;
+    if constexpr (std::is_floating_point<Utility>::value) {
+        for (; idx + 16 <= count; idx += 16) {
+            const __m512i first = _mm512_loadu_si512(offsets + idx);
+            float lanes[16];
+            _mm512_storeu_ps(lanes, _mm512_add_ps(_mm512_i32gather_ps(first, utility, 4), _mm512_i32gather_ps(first, rem, 4)));
+            for (auto lane : lanes) total += lane;
+        }
+    } else if constexpr (sizeof(Utility) == 4) {
+        __m512i sum = _mm512_setzero_si512();
+        for (; idx + 16 <= count; idx += 16) {
+            const __m512i first = _mm512_loadu_si512(offsets + idx);
+            sum = _mm512_add_epi32(sum, _mm512_add_epi32(_mm512_i32gather_epi32(first, utility, 4), _mm512_i32gather_epi32(first, rem, 4)));
+        }
+        total += _mm512_reduce_add_epi32(sum);
+    } else {
+        __m512i sum = _mm512_setzero_si512();
+        for (; idx + 8 <= count; idx += 8) {
+            const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + idx));
+            sum = _mm512_add_epi64(sum, _mm512_add_epi64(_mm512_i32gather_epi64(first, utility, 8), _mm512_i32gather_epi64(first, rem, 8)));
+        }
+        total += _mm512_reduce_add_epi64(sum);
+    }
+    for (; idx < count; ++idx) total += utility[offsets[idx]] + rem[offsets[idx]];
+    return total;
+}
+
+template <typename Position, typename Sid>
+TARGET_AVX512 static unsigned int sumExtentsAvx512(
+    const Position *position,
+    const Sid *sids,
+    const unsigned int *offsets,
+    const unsigned int *sequenceSizes,
+    size_t count
+) {
+    const size_t vectorEnd = sizeof(Position) == 2 && count ? count - 1 : count;
+    __m512i sum = _mm512_setzero_si512();
+    size_t idx = 0;
+    for (; idx + 16 <= vectorEnd; idx += 16) {
+        const __m512i first = _mm512_loadu_si512(offsets + idx);
+        __m512i sid, firstPosition;
+        if constexpr (sizeof(Sid) == 2) sid = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sids + idx)));
+        else sid = _mm512_loadu_si512(sids + idx);
+        if constexpr (sizeof(Position) == 2)
+            firstPosition = _mm512_and_si512(_mm512_i32gather_epi32(first, position, 2), _mm512_set1_epi32(0xffff));
+        else firstPosition = _mm512_i32gather_epi32(first, position, 4);
+        sum = _mm512_add_epi32(sum, _mm512_sub_epi32(_mm512_i32gather_epi32(sid, sequenceSizes, 4), firstPosition));
+    }
+    unsigned int total = _mm512_reduce_add_epi32(sum);
+    for (; idx < count; ++idx) total += sequenceSizes[sids[idx]] - position[offsets[idx]];
+    return total;
+}
+
+template <typename Utility>
+Utility sumMinima(const Utility *utility, const unsigned int *offsets, size_t count, KernelSet kernels) {
+    switch (kernels) {
+        case KernelSet::AVX512: return sumMinimaAvx512(utility, offsets, count);
+        case KernelSet::AVX2: return sumMinimaAvx2(utility, offsets, count);
+        default: return sumMinimaScalar(utility, offsets, count);
+    }
+}
+
+template <typename Utility>
+Utility sumFirsts(const Utility *utility, const Utility *rem, const unsigned int *offsets, size_t count, KernelSet kernels) {
+    switch (kernels) {
+        case KernelSet::AVX512: return sumFirstsAvx512(utility, rem, offsets, count);
+        case KernelSet::AVX2: return sumFirstsAvx2(utility, rem, offsets, count);
+        default: return sumFirstsScalar(utility, rem, offsets, count);
+    }
+}
+
+template <typename Position, typename Sid>
+unsigned int sumExtents(
+    const Position *position,
+    const Sid *sids,
+    const unsigned int *offsets,
+    const unsigned int *sequenceSizes,
+    size_t count,
+    KernelSet kernels
+) {
+    switch (kernels) {
+        case KernelSet::AVX512: return sumExtentsAvx512(position, sids, offsets, sequenceSizes, count);
+        case KernelSet::AVX2: return sumExtentsAvx2(position, sids, offsets, sequenceSizes, count);
+        default: return sumExtentsScalar(position, sids, offsets, sequenceSizes, count);
+    }
+}
+
+#define INSTANTIATE(Utility) \
+    template Utility sumMinima(const Utility *utility, const unsigned int *offsets, size_t count, KernelSet kernels); \
+    template Utility sumFirsts(const Utility *utility, const Utility *rem, const unsigned int *offsets, size_t count, KernelSet kernels);
+INSTANTIATE(float)
+INSTANTIATE(int32_t)
+INSTANTIATE(int64_t)
+#undef INSTANTIATE
+
+#define INSTANTIATE(Position, Sid) \
+    template unsigned int sumExtents( \
+        const Position *position, const Sid *sids, const unsigned int *offsets, \
+        const unsigned int *sequenceSizes, size_t count, KernelSet kernels \
+    );
+INSTANTIATE(uint16_t, uint16_t)
+INSTANTIATE(uint16_t, uint32_t)
+INSTANTIATE(uint32_t, uint16_t)
+INSTANTIATE(uint32_t, uint32_t)
+#undef INSTANTIATE
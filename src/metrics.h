@@ -0,0 +1,53 @@
+/*
+    Kernels computing the metrics of a pattern over the columns of its SIDUL, for a range of
+    its sequences given by their offsets: offsets[idx] is the first instance of the idx-th
+    sequence and offsets[count] the end of the last one.
+
+    Besides the scalar fallback, the kernels are compiled for AVX2 and AVX-512 whatever the
+    target of the build, and the widest set the CPU supports is picked when they are first
+    used. Float sums are added in the order of the sequences whatever the set, so all of them
+    give the results of the scalar kernels bit for bit.
+*/
+#pragma once
+#include <cstddef>
+#include <string>
+
+enum class KernelSet { SCALAR, AVX2, AVX512 };
+
+/*
+    Widest set of kernels the CPU supports
+*/
+KernelSet detect_kernels();
+/*
+    Set used by default, detected once
+*/
+KernelSet active_kernels();
+std::string kernels_name(KernelSet kernels);
+
+/*
+    Sum over the sequences of the least utility of their instances, i.e. umin
+*/
+template <typename Utility>
+Utility sumMinima(const Utility *utility, const unsigned int *offsets, size_t count, KernelSet kernels = active_kernels());
+/*
+    Sum over the sequences of the utility and remaining utility of their first instance, i.e. RBU
+*/
+template <typename Utility>
+Utility sumFirsts(const Utility *utility, const Utility *rem, const unsigned int *offsets, size_t count, KernelSet kernels = active_kernels());
+/*
+    Sum over the sequences of the itemsets from their first instance on, i.e. SE, given the
+    number of itemsets of every sequence by sequence id
+*/
+template <typename Position, typename Sid>
+unsigned int sumExtents(
+    const Position *position,
+    const Sid *sids,
+    const unsigned int *offsets,
+    const unsigned int *sequenceSizes,
+    size_t count,
+    KernelSet kernels = active_kernels()
+);
+/*
+    Number of instances of the sequences, i.e. SLIP
+*/
+inline unsigned int countInstances(const unsigned int *offsets, size_t count) { return offsets[count] - offsets[0]; }
@@ -1,23 +1,122 @@
+#include <algorithm>
 #include "models.h"
-
-Item::Item(int id) {
-    this->id = id;
-    this->utility = 0;
-}
+#include "bitset.h"
 
 Sequence::Sequence() {
     this->size = 0;
     this->utility = 0;
+    this->items = nullptr;
+    this->length = 0;
+}
+
+const Item* Sequence::begin() const {
+    return this->items;
+}
+
+const Item* Sequence::end() const {
+    return this->items + this->length;
+}
+
+Database::Database() {}
+
+void Database::link(const Item *base) {
+    for (auto &sequence : this->sequences) {
+        sequence.items = base;
+        base += sequence.length;
+    }
+}
+
+unsigned int Database::numSequences() const {
+    unsigned int numSequences = 0;
+    for (auto &sequence : this->sequences) if (sequence.length) ++numSequences;
+    return numSequences;
+}
+
+template <typename Utility, typename Position, typename Sid>
+BasicSidul<Utility, Position, Sid>::BasicSidul(std::pmr::memory_resource *resource) :
+    sids(resource), offsets(resource), utility(resource), rem(resource), position(resource) {
+    this->offsets.push_back(0);
 }
 
-ItemInstance::ItemInstance(float utility, float rem, unsigned int position) {
-    this->utility = utility;
-    this->position = position;
-    this->rem = rem;
+template <typename Utility, typename Position, typename Sid>
+void BasicSidul<Utility, Position, Sid>::addInstance(unsigned int sid, Utility utility, Utility rem, unsigned int position) {
+    if (this->sids.empty() || this->sids.back() != sid) {
+        this->sids.push_back(sid);
+        this->offsets.push_back(this->offsets.back());
+    }
+    this->utility.push_back(utility);
+    this->rem.push_back(rem);
+    this->position.push_back(position);
+    ++this->offsets.back();
 }
 
-Pattern::Pattern() {
-    this->name = "";
+template <typename Utility, typename Position, typename Sid>
+void BasicSidul<Utility, Position, Sid>::reserve(unsigned int sequences, unsigned int instances) {
+    this->sids.reserve(sequences);
+    this->offsets.reserve(sequences + 1);
+    this->utility.reserve(instances);
+    this->rem.reserve(instances);
+    this->position.reserve(instances);
+}
+
+template <typename Utility, typename Position, typename Sid>
+void BasicSidul<Utility, Position, Sid>::append(const BasicSidul &other, unsigned int sidOffset) {
+    const unsigned int base = this->offsets.back();
+    this->sids.reserve(this->sids.size() + other.sids.size());
+    for (auto sid : other.sids) this->sids.push_back(sid + sidOffset);
+    for (unsigned int idx = 1; idx < other.offsets.size(); ++idx) this->offsets.push_back(base + other.offsets[idx]);
+    this->utility.insert(this->utility.end(), other.utility.begin(), other.utility.end());
+    this->rem.insert(this->rem.end(), other.rem.begin(), other.rem.end());
+    this->position.insert(this->position.end(), other.position.begin(), other.position.end());
+}
+
+SidulBits::SidulBits(std::pmr::memory_resource *resource) :
+    sids(resource), positionOffsets(1, 0, resource), positions(resource) {
+    this->firstWord = 0;
+}
+
+template <typename Utility, typename Position, typename Sid>
+SidulBits::SidulBits(const BasicSidul<Utility, Position, Sid> &siduls, std::pmr::memory_resource *resource) : SidulBits(resource) {
+    if (siduls.size() == 0) return;
+    this->firstWord = siduls.sids.front() / WORD_BITS;
+    this->sids.assign(siduls.sids.back() / WORD_BITS - this->firstWord + 1, 0);
+    for (auto sid : siduls.sids) this->sids[sid / WORD_BITS - this->firstWord] |= uint64_t(1) << (sid % WORD_BITS);
+    this->positionOffsets.reserve(siduls.size() + 1);
+    for (unsigned int idx = 0; idx < siduls.size(); ++idx) {
+        /*
+            Instances are ordered by position, so the last one tells the number of words needed
+        */
+        const unsigned int base = this->positionOffsets.back();
+        this->positions.resize(base + siduls.position[siduls.end(idx) - 1] / WORD_BITS + 1, 0);
+        for (unsigned int instance = siduls.begin(idx); instance < siduls.end(idx); ++instance)
+            this->positions[base + siduls.position[instance] / WORD_BITS] |= uint64_t(1) << (siduls.position[instance] % WORD_BITS);
+        this->positionOffsets.push_back(this->positions.size());
+    }
+}
+
+unsigned int SidulBits::commonSupport(const SidulBits &other) const {
+    const unsigned int first = std::max(this->firstWord, other.firstWord);
+    const unsigned int last = std::min(this->firstWord + this->sids.size(), other.firstWord + other.sids.size());
+    if (first >= last) return 0;
+    return popcountAnd(&this->sids[first - this->firstWord], &other.sids[first - other.firstWord], last - first);
+}
+
+long SidulBits::firstCommonPosition(unsigned int idx, const SidulBits &other, unsigned int otherIdx) const {
+    const uint64_t *words = &this->positions[this->positionOffsets[idx]];
+    const uint64_t *otherWords = &other.positions[other.positionOffsets[otherIdx]];
+    const unsigned int length = std::min(
+        this->positionOffsets[idx + 1] - this->positionOffsets[idx],
+        other.positionOffsets[otherIdx + 1] - other.positionOffsets[otherIdx]
+    );
+    /*
+        Most sequences have fewer than WORD_BITS itemsets
+    */
+    if (length == 1) return words[0] & otherWords[0] ? __builtin_ctzll(words[0] & otherWords[0]) : -1;
+    return firstCommonBit(words, otherWords, length);
+}
+
+template <typename Utility, typename Position, typename Sid>
+BasicPattern<Utility, Position, Sid>::BasicPattern(std::pmr::memory_resource *resource) : items(resource), siduls(resource) {
     this->lastItem = -1;
     this->parentLastItem = -1;
     this->do_ext = true;
@@ -31,3 +130,10 @@ Pattern::Pattern() {
     this->SE = 0;
     this->SLIP = 0;
 }
+
+#define INSTANTIATE(Utility, Position, Sid) \
+    template class BasicSidul<Utility, Position, Sid>; \
+    template SidulBits::SidulBits(const BasicSidul<Utility, Position, Sid> &siduls, std::pmr::memory_resource *resource); \
+    template class BasicPattern<Utility, Position, Sid>;
+SEARCH_LAYOUTS(INSTANTIATE)
+#undef INSTANTIATE
@@ -3,39 +3,139 @@
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <cstdint>
+#include <memory_resource>
 
+/*
+    A token of a sequence: an item with its utility, or END_ITEMSET/END_SEQUENCE with no utility.
+    This is also the record layout of the binary dataset, whose mapped records are used in place.
+*/
 class Item {
     public:
-        int id;
+        int32_t id;
         float utility;
-
-        Item(int id);
 };
 
+/*
+    View over the items of a sequence, owned by a Database
+*/
 class Sequence {
     public:
         unsigned int size;
         float utility;
-        std::vector<std::shared_ptr<Item>> items;
+        const Item *items;
+        unsigned int length;
 
         Sequence();
+        const Item* begin() const;
+        const Item* end() const;
 };
 
-class ItemInstance {
+/*
+    Sequences indexed by their id. Sequences left without items by pruning are kept empty so
+    that ids stay stable. Items are either owned in records or live in a mapped binary file.
+*/
+class Database {
     public:
-        float utility;
-        float rem;
-        unsigned int position;
+        std::vector<Sequence> sequences;
+        std::vector<Item> records;
+        std::shared_ptr<void> mapping;
+
+        Database();
+        Database(Database &&) = default;
+        Database& operator=(Database &&) = default;
+        Database(const Database &) = delete;
+        Database& operator=(const Database &) = delete;
+        /*
+            Point the sequences at consecutive ranges of items starting from base, each sequence
+            taking as many items as its length.
+        */
+        void link(const Item *base);
+        unsigned int numSequences() const;
+};
+
+/*
+    SIDUL of a pattern stored contiguously instead of one heap allocated instance per entry.
 
-        ItemInstance(float utility, float rem, unsigned int position);
+    Sequence ids are kept in ascending order in sids. The instances of sids[i] are found at
+    [offsets[i], offsets[i+1]) of the utility/rem/position columns, ordered by position.
+    The columns are carved from the given memory resource, e.g. the arena of a search node.
+    Utilities are floats as loaded, or integers in fixed point for the search (see fixed.h).
+    Positions and sequence ids are stored in 32 bits, or in 16 bits for the search when the
+    dataset fits them (see layout.h).
+*/
+template <typename Utility, typename Position = unsigned int, typename Sid = unsigned int>
+class BasicSidul {
+    public:
+        std::pmr::vector<Sid> sids;
+        std::pmr::vector<unsigned int> offsets;
+        std::pmr::vector<Utility> utility;
+        std::pmr::vector<Utility> rem;
+        std::pmr::vector<Position> position;
+
+        BasicSidul(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+        /*
+            Number of sequences containing the pattern, i.e. its support
+        */
+        unsigned int size() const { return this->sids.size(); }
+        unsigned int begin(unsigned int idx) const { return this->offsets[idx]; }
+        unsigned int end(unsigned int idx) const { return this->offsets[idx + 1]; }
+        /*
+            Instances must be added in ascending order of (sid, position)
+        */
+        void addInstance(unsigned int sid, Utility utility, Utility rem, unsigned int position);
+        /*
+            Allocate once for an upper bound of the sequences and instances to be added
+        */
+        void reserve(unsigned int sequences, unsigned int instances);
+        /*
+            Instances of the other SIDUL must all belong to sequences after the last one here,
+            once sidOffset is added to its sequence ids
+        */
+        void append(const BasicSidul &other, unsigned int sidOffset = 0);
 };
 
-class Pattern {
+using Sidul = BasicSidul<float>;
+
+/*
+    Bitmaps of a SIDUL for screening candidate extensions without merging instances.
+
+    sids covers the words [firstWord, firstWord + sids.size()) of the bitmap over sequence ids.
+    The itemset positions of the instances of the i-th sequence of the SIDUL are set in
+    the words [positionOffsets[i], positionOffsets[i+1]) of positions.
+*/
+class SidulBits {
     public:
-        std::string name;
+        unsigned int firstWord;
+        std::pmr::vector<uint64_t> sids;
+        std::pmr::vector<unsigned int> positionOffsets;
+        std::pmr::vector<uint64_t> positions;
+
+        SidulBits(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+        template <typename Utility, typename Position, typename Sid>
+        SidulBits(const BasicSidul<Utility, Position, Sid> &siduls, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+        /*
+            Number of sequences both SIDULs occur in, an upper bound of the support of any extension
+        */
+        unsigned int commonSupport(const SidulBits &other) const;
+        /*
+            First itemset position at which the idx-th sequence here and the otherIdx-th one of
+            the other SIDUL, the same sequence, both have an instance, or -1 when there is none
+        */
+        long firstCommonPosition(unsigned int idx, const SidulBits &other, unsigned int otherIdx) const;
+};
+
+template <typename Utility, typename Position = unsigned int, typename Sid = unsigned int>
+class BasicPattern {
+    public:
+        /*
+            Items of the pattern in order, consecutive itemsets are separated by END_ITEMSET.
+            The textual form is only produced when the pattern is output.
+        */
+        std::pmr::vector<int> items;
         int lastItem;
         bool isSExt;
-        std::unordered_map<unsigned int, std::vector<std::shared_ptr<ItemInstance>>> siduls;
+        BasicSidul<Utility, Position, Sid> siduls;
         bool isMaximal;
         bool do_ext;
         bool do_s_ext;
@@ -48,9 +148,45 @@ class Pattern {
         /*
             To speed up, these metrics are cached in a pattern when the pattern is constructed
         */
-        float RBU;
-        float umin;
+        Utility RBU;
+        Utility umin;
         unsigned int SE;
         unsigned int SLIP;
-        Pattern();
-};
\ No newline at end of file
+        /*
+            Items and SIDUL are allocated from the given memory resource
+        */
+        BasicPattern(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+};
+
+using Pattern = BasicPattern<float>;
+
+/*
+    Read-only data of a mining run, shared by all the search tasks instead of being copied per node.
+    Sequence sizes are indexed by sequence id and item SIDULs are densely indexed in ascending
+    order of the item ids, so candidate item lists are plain vectors of indices. The bitmaps of
+    their SIDULs are kept at the same indices.
+
+    When sequences are appended to a previous run, only patterns occurring in the sequences
+    from firstSid on are searched, the others are not affected by the new sequences.
+*/
+template <typename Utility, typename Position = unsigned int, typename Sid = unsigned int>
+class BasicMiningContext {
+    public:
+        std::vector<unsigned int> sequenceSizes;
+        std::vector<std::shared_ptr<BasicPattern<Utility, Position, Sid>>> items;
+        std::vector<SidulBits> itemBits;
+        unsigned int firstSid = 0;
+};
+
+using MiningContext = BasicMiningContext<float>;
+
+/*
+    Layouts the search is instantiated for, as X(Utility, Position, Sid)
+*/
+#define SEARCH_LAYOUTS(X) \
+    X(float, uint16_t, uint16_t) X(float, uint16_t, uint32_t) \
+    X(float, uint32_t, uint16_t) X(float, uint32_t, uint32_t) \
+    X(int32_t, uint16_t, uint16_t) X(int32_t, uint16_t, uint32_t) \
+    X(int32_t, uint32_t, uint16_t) X(int32_t, uint32_t, uint32_t) \
+    X(int64_t, uint16_t, uint16_t) X(int64_t, uint16_t, uint32_t) \
+    X(int64_t, uint32_t, uint16_t) X(int64_t, uint32_t, uint32_t)
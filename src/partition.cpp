@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "omp.h"
+#include "partition.h"
+#include "utils.h"
+
+static bool isNumber(const std::string &value) {
+    return !value.empty() && std::all_of(value.begin(), value.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+}
+
+static std::string partitionName(const Partition &partition) {
+    return std::to_string(partition.index) + "/" + std::to_string(partition.count);
+}
+
+bool parsePartition(const std::string &value, Partition &partition) {
+    const size_t slash = value.find('/');
+    if (slash == std::string::npos) return false;
+    const std::string index = value.substr(0, slash), count = value.substr(slash + 1);
+    if (!isNumber(index) || !isNumber(count)) return false;
+    partition.index = std::stoul(index);
+    partition.count = std::stoul(count);
+    return partition.index < partition.count;
+}
+
+template <typename Utility, typename Position, typename Sid>
+std::vector<unsigned int> partition_items(const BasicMiningContext<Utility, Position, Sid> &context, unsigned int count) {
+    std::vector<unsigned int> order(context.items.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+        return context.items[a]->siduls.utility.size() > context.items[b]->siduls.utility.size();
+    });
+    std::vector<uint64_t> work(count, 0);
+    std::vector<unsigned int> partitions(context.items.size());
+    for (auto itemIdx : order) {
+        const unsigned int partition = std::min_element(work.begin(), work.end()) - work.begin();
+        partitions[itemIdx] = partition;
+        work[partition] += context.items[itemIdx]->siduls.utility.size();
+    }
+    return partitions;
+}
+
+#define INSTANTIATE(Utility, Position, Sid) \
+    template std::vector<unsigned int> partition_items(const BasicMiningContext<Utility, Position, Sid> &context, unsigned int count);
+SEARCH_LAYOUTS(INSTANTIATE)
+#undef INSTANTIATE
+
+PartitionOutput readPartitionOutput(std::istream &in, const std::string &name) {
+    const std::string PARTITION_PREFIX = "# partition: ", TOTAL_PREFIX = "Total: ", SUPPORT_PREFIX = ", supp=";
+    PartitionOutput output;
+    bool hasPartition = false, isComplete = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind(PARTITION_PREFIX, 0) == 0) {
+            if (!parsePartition(line.substr(PARTITION_PREFIX.size()), output.partition))
+                throw std::runtime_error(name + " has an invalid partition");
+            hasPartition = true;
+        }
+        else if (line.rfind("#", 0) == 0) output.header = line;
+        else if (line.rfind(TOTAL_PREFIX, 0) == 0) {
+            isComplete = std::stoul(line.substr(TOTAL_PREFIX.size())) == output.patterns.size();
+            break;
+        }
+        else {
+            const size_t support = line.find(SUPPORT_PREFIX);
+            if (support == std::string::npos) throw std::runtime_error(name + " has an invalid line: " + line);
+            PartitionPattern pattern;
+            std::istringstream items(line.substr(0, support));
+            int item;
+            while (items >> item) pattern.items.push_back(item);
+            pattern.support = std::stoul(line.substr(support + SUPPORT_PREFIX.size()));
+            pattern.line = line;
+            output.patterns.push_back(std::move(pattern));
+        }
+    }
+    if (!hasPartition) throw std::runtime_error(name + " is not the output of a partition");
+    if (!isComplete) throw std::runtime_error(name + " is truncated");
+    return output;
+}
+
+void writeMergedOutput(const std::vector<PartitionOutput> &outputs, std::ostream &out) {
+    if (outputs.empty()) throw std::runtime_error("no partition to merge");
+    const unsigned int count = outputs[0].partition.count;
+    std::vector<const PartitionOutput*> partitions(count, nullptr);
+    for (auto &output : outputs) {
+        if (output.partition.count != count || output.header != outputs[0].header)
+            throw std::runtime_error("partition " + partitionName(output.partition) + " is not from the same run");
+        if (partitions[output.partition.index])
+            throw std::runtime_error("partition " + partitionName(output.partition) + " is given twice");
+        partitions[output.partition.index] = &output;
+    }
+    for (unsigned int index = 0; index < count; ++index)
+        if (!partitions[index]) throw std::runtime_error("partition " + partitionName({index, count}) + " is missing");
+
+    std::vector<const PartitionPattern*> patterns;
+    std::vector<unsigned int> owners;
+    for (unsigned int index = 0; index < count; ++index)
+        for (auto &pattern : partitions[index]->patterns) {
+            patterns.push_back(&pattern);
+            owners.push_back(index);
+        }
+    /*
+        A subsuming pattern has the same support and more items. Patterns are ordered by
+        support then by decreasing length, so those that may subsume a pattern are the ones
+        from the start of its support up to the first one no longer than it. Patterns of the
+        same partition were already checked against each other by its closed set.
+    */
+    std::vector<unsigned int> order(patterns.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+        if (patterns[a]->support != patterns[b]->support) return patterns[a]->support < patterns[b]->support;
+        return patterns[a]->items.size() > patterns[b]->items.size();
+    });
+    std::vector<size_t> supportBegin(order.size());
+    for (size_t rank = 0; rank < order.size(); ++rank)
+        supportBegin[rank] = rank && patterns[order[rank]]->support == patterns[order[rank - 1]]->support ? supportBegin[rank - 1] : rank;
+
+    std::vector<char> isSubsumed(patterns.size(), false);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t rank = 0; rank < order.size(); ++rank) {
+        const unsigned int idx = order[rank];
+        for (size_t other = supportBegin[rank]; other < rank; ++other) {
+            const unsigned int otherIdx = order[other];
+            if (patterns[otherIdx]->items.size() <= patterns[idx]->items.size()) break;
+            if (owners[otherIdx] != owners[idx] && isContainedBy(patterns[otherIdx]->items, patterns[idx]->items)) {
+                isSubsumed[idx] = true;
+                break;
+            }
+        }
+    }
+
+    size_t numOfPattern = 0;
+    out << outputs[0].header << std::endl;
+    for (size_t idx = 0; idx < patterns.size(); ++idx) {
+        if (isSubsumed[idx]) continue;
+        out << patterns[idx]->line << std::endl;
+        ++numOfPattern;
+    }
+    out << "Total: " << numOfPattern << std::endl;
+}
+
+std::vector<PartitionOutput> run_partitions(const std::vector<std::string> &arguments, unsigned int count) {
+    std::vector<pid_t> children;
+    std::vector<int> pipes;
+    for (unsigned int index = 0; index < count; ++index) {
+        /*
+            Everything the child needs is prepared before forking, it only redirects its
+            output and replaces itself with a fresh copy of the executable
+        */
+        std::vector<std::string> childArguments = arguments;
+        childArguments.push_back("--partition");
+        childArguments.push_back(partitionName({index, count}));
+        std::vector<char*> argv;
+        for (auto &argument : childArguments) argv.push_back(const_cast<char*>(argument.c_str()));
+        argv.push_back(nullptr);
+
+        int fds[2];
+        if (pipe(fds) != 0) throw std::runtime_error("cannot create a pipe for partition " + partitionName({index, count}));
+        const pid_t pid = fork();
+        if (pid < 0) throw std::runtime_error("cannot start partition " + partitionName({index, count}));
+        if (pid == 0) {
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+            for (auto fd : pipes) close(fd);
+            execv("/proc/self/exe", argv.data());
+            _exit(127);
+        }
+        close(fds[1]);
+        children.push_back(pid);
+        pipes.push_back(fds[0]);
+    }
+
+    /*
+        Children only write their patterns once their search is over, so reading the pipes one
+        after the other never holds up a search
+    */
+    std::vector<std::string> texts(count);
+    for (unsigned int index = 0; index < count; ++index) {
+        char buffer[1 << 16];
+        ssize_t length;
+        while ((length = read(pipes[index], buffer, sizeof(buffer))) > 0) texts[index].append(buffer, length);
+        close(pipes[index]);
+    }
+    bool isFailed = false;
+    for (auto pid : children) {
+        int status;
+        waitpid(pid, &status, 0);
+        isFailed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    if (isFailed) throw std::runtime_error("a partition failed");
+
+    std::vector<PartitionOutput> outputs;
+    for (unsigned int index = 0; index < count; ++index) {
+        std::istringstream in(texts[index]);
+        outputs.push_back(readPartitionOutput(in, "partition " + partitionName({index, count})));
+    }
+    return outputs;
+}
@@ -0,0 +1,63 @@
+/*
+    Partitioned mining, spreading one search over processes that may run on other machines.
+
+    A pattern is only ever found in the subtree of its first item, so the search is split by
+    the item at the root of each subtree. Every partition mines the subtrees of its share of
+    the items and outputs the patterns closed among those it found, in the usual format with
+    a "# partition: i/N" line after the header. A pattern of one partition may be subsumed by
+    a pattern with the same support found by another, which a full run would have evicted from
+    the closed set, so the outputs of all partitions are merged by removing those.
+*/
+#pragma once
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "models.h"
+
+class Partition {
+    public:
+        unsigned int index = 0;
+        unsigned int count = 1;
+};
+
+/*
+    Parse "i/N", with 0 <= i < N
+*/
+bool parsePartition(const std::string &value, Partition &partition);
+/*
+    Partition of each item of the context as a root. The work of a root is estimated by the
+    number of its instances, and roots are handed out from the largest one to the partition
+    with the least work so far. Every process computes the same assignment.
+*/
+template <typename Utility, typename Position, typename Sid>
+std::vector<unsigned int> partition_items(const BasicMiningContext<Utility, Position, Sid> &context, unsigned int count);
+
+class PartitionPattern {
+    public:
+        std::pmr::vector<int> items;
+        unsigned int support;
+        /*
+            The line output for the pattern, written back as is
+        */
+        std::string line;
+};
+
+class PartitionOutput {
+    public:
+        std::string header;
+        Partition partition;
+        std::vector<PartitionPattern> patterns;
+};
+
+PartitionOutput readPartitionOutput(std::istream &in, const std::string &name);
+/*
+    Write the patterns of all partitions, one output each, that are not subsumed by a pattern
+    of another partition with the same support, in the format of a full run
+*/
+void writeMergedOutput(const std::vector<PartitionOutput> &outputs, std::ostream &out);
+/*
+    Run the running executable once per partition with the given arguments, to which
+    --partition i/N is added, and read their outputs
+*/
+std::vector<PartitionOutput> run_partitions(const std::vector<std::string> &arguments, unsigned int count);
@@ -0,0 +1,242 @@
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include "omp.h"
+#include "state.h"
+#include "utils.h"
+
+template <typename T>
+static void writeValue(std::ofstream &file, const T &value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename Vector>
+static void writeVector(std::ofstream &file, const Vector &values) {
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+}
+
+template <typename T>
+static T readValue(std::ifstream &file) {
+    T value;
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+template <typename Vector>
+static void readVector(std::ifstream &file, Vector &values, size_t size) {
+    values.resize(size);
+    file.read(reinterpret_cast<char*>(values.data()), size * sizeof(values[0]));
+}
+
+MiningState readState(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("cannot open " + path);
+    const StateHeader header = readValue<StateHeader>(file);
+    if (
+        !file ||
+        std::memcmp(header.magic, STATE_MAGIC, sizeof(STATE_MAGIC)) != 0 ||
+        header.version != STATE_VERSION
+    ) throw std::runtime_error(path + " is not a supported mining state");
+
+    MiningState state;
+    state.minSupport = header.minSupport;
+    state.minUtility = header.minUtility;
+    readVector(file, state.sequenceUtilities, header.numSequences);
+    readVector(file, state.sequenceSizes, header.numSequences);
+    for (uint32_t idx = 0; idx < header.numItems && file; ++idx) {
+        std::shared_ptr<Pattern> item = std::make_shared<Pattern>();
+        item->lastItem = readValue<int32_t>(file);
+        item->items.push_back(item->lastItem);
+        item->size = 1;
+        const uint32_t numSids = readValue<uint32_t>(file), numInstances = readValue<uint32_t>(file);
+        Sidul &siduls = item->siduls;
+        readVector(file, siduls.sids, numSids);
+        readVector(file, siduls.offsets, numSids + 1);
+        readVector(file, siduls.utility, numInstances);
+        readVector(file, siduls.rem, numInstances);
+        readVector(file, siduls.position, numInstances);
+        item->umin = readValue<float>(file);
+        item->RBU = readValue<float>(file);
+        item->SE = readValue<uint32_t>(file);
+        item->SLIP = readValue<uint32_t>(file);
+        state.items[item->lastItem] = item;
+    }
+    state.patterns.resize(header.numPatterns);
+    for (auto &pattern : state.patterns) {
+        const uint32_t length = readValue<uint32_t>(file);
+        pattern.support = readValue<uint32_t>(file);
+        pattern.umin = readValue<float>(file);
+        readVector(file, pattern.items, length);
+        pattern.size = std::count(pattern.items.begin(), pattern.items.end(), END_ITEMSET) + 1;
+        if (!file) break;
+    }
+    if (!file) throw std::runtime_error(path + " is truncated");
+
+    return state;
+}
+
+void writeState(const MiningState &state, const std::string &path) {
+    const std::string partialPath = path + ".partial";
+    std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("cannot write " + partialPath);
+
+    StateHeader header;
+    std::memcpy(header.magic, STATE_MAGIC, sizeof(STATE_MAGIC));
+    header.version = STATE_VERSION;
+    header.minSupport = state.minSupport;
+    header.minUtility = state.minUtility;
+    header.numItems = state.items.size();
+    header.numSequences = state.sequenceUtilities.size();
+    header.numPatterns = state.patterns.size();
+    writeValue(file, header);
+    writeVector(file, state.sequenceUtilities);
+    writeVector(file, state.sequenceSizes);
+    for (auto &item : state.items) {
+        const Sidul &siduls = item.second->siduls;
+        writeValue<int32_t>(file, item.first);
+        writeValue<uint32_t>(file, siduls.sids.size());
+        writeValue<uint32_t>(file, siduls.utility.size());
+        writeVector(file, siduls.sids);
+        writeVector(file, siduls.offsets);
+        writeVector(file, siduls.utility);
+        writeVector(file, siduls.rem);
+        writeVector(file, siduls.position);
+        writeValue<float>(file, item.second->umin);
+        writeValue<float>(file, item.second->RBU);
+        writeValue<uint32_t>(file, item.second->SE);
+        writeValue<uint32_t>(file, item.second->SLIP);
+    }
+    for (auto &pattern : state.patterns) {
+        writeValue<uint32_t>(file, pattern.items.size());
+        writeValue<uint32_t>(file, pattern.support);
+        writeValue<float>(file, pattern.umin);
+        writeVector(file, pattern.items);
+    }
+    file.close();
+    if (!file || std::rename(partialPath.c_str(), path.c_str()) != 0) throw std::runtime_error("cannot write " + path);
+}
+
+std::vector<FCloPattern> unaffected_patterns(
+    const MiningState &state,
+    const Database &delta,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &deltaItems
+) {
+    std::vector<std::pmr::vector<int>> deltaSequences(delta.sequences.size());
+    for (unsigned int seqID = 0; seqID < delta.sequences.size(); ++seqID)
+        for (auto &item : delta.sequences[seqID])
+            if (item.id != END_SEQUENCE) deltaSequences[seqID].push_back(item.id);
+
+    std::vector<char> isAffected(state.patterns.size(), false);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t idx = 0; idx < state.patterns.size(); ++idx) {
+        /*
+            Only the delta sequences containing the rarest item of the pattern need to be checked
+        */
+        const FCloPattern &pattern = state.patterns[idx];
+        const Sidul *rarest = nullptr;
+        for (auto id : pattern.items) {
+            if (id == END_ITEMSET) continue;
+            auto item = deltaItems.find(id);
+            if (item == deltaItems.end()) {
+                rarest = nullptr;
+                break;
+            }
+            if (!rarest || item->second->siduls.size() < rarest->size()) rarest = &item->second->siduls;
+        }
+        if (!rarest) continue;
+        for (auto sid : rarest->sids) {
+            if (isContainedBy(deltaSequences[sid], pattern.items)) {
+                isAffected[idx] = true;
+                break;
+            }
+        }
+    }
+
+    std::vector<FCloPattern> patterns;
+    for (size_t idx = 0; idx < state.patterns.size(); ++idx)
+        if (!isAffected[idx]) patterns.push_back(state.patterns[idx]);
+    return patterns;
+}
+
+void append_delta(
+    MiningState &state,
+    const Database &delta,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &deltaItems
+) {
+    const unsigned int firstSid = state.sequenceUtilities.size();
+    for (auto &sequence : delta.sequences) {
+        state.sequenceUtilities.push_back(sequence.utility);
+        state.sequenceSizes.push_back(sequence.size);
+    }
+    for (auto &deltaItem : deltaItems) {
+        std::shared_ptr<Pattern> &item = state.items[deltaItem.first];
+        if (!item) {
+            item = std::make_shared<Pattern>();
+            item->lastItem = deltaItem.first;
+            item->items.push_back(deltaItem.first);
+            item->size = 1;
+        }
+        merge_siduls(*item, *deltaItem.second, firstSid);
+        /*
+            Summed again in the order of the sequences, as a full run does, rather than
+            as the previous total plus the delta's
+        */
+        const Sidul &siduls = item->siduls;
+        item->umin = 0;
+        for (unsigned int idx = 0; idx < siduls.size(); ++idx)
+            item->umin += *std::min_element(siduls.utility.begin() + siduls.begin(idx), siduls.utility.begin() + siduls.end(idx));
+    }
+}
+
+MiningContext construct_context(
+    const MiningState &state,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &deltaItems,
+    unsigned int firstSid,
+    float MIN_SUPP,
+    float MIN_UTILITY,
+    unsigned int &numItems,
+    unsigned int &numSequences
+) {
+    /*
+        Items are removed until none is left to remove, as shrink_database does, the utilities
+        of the pruned sequences being summed from the SIDULs of the items kept, in ascending
+        order of id
+    */
+    std::vector<std::pair<int, std::shared_ptr<Pattern>>> kept(state.items.begin(), state.items.end());
+    std::sort(kept.begin(), kept.end(), [](const std::pair<int, std::shared_ptr<Pattern>> &a, const std::pair<int, std::shared_ptr<Pattern>> &b) {
+        return a.first < b.first;
+    });
+    std::vector<float> sequenceUtilities = state.sequenceUtilities;
+    size_t numKept = 0;
+    for (;;) {
+        kept.erase(std::remove_if(kept.begin(), kept.end(), [&](const std::pair<int, std::shared_ptr<Pattern>> &item) {
+            const Sidul &siduls = item.second->siduls;
+            float LRU = 0;
+            for (auto sid : siduls.sids) LRU += sequenceUtilities[sid];
+            return siduls.size() < MIN_SUPP || LRU < MIN_UTILITY;
+        }), kept.end());
+        if (kept.size() == numKept) break;
+        numKept = kept.size();
+        std::fill(sequenceUtilities.begin(), sequenceUtilities.end(), 0);
+        for (auto &item : kept) {
+            const Sidul &siduls = item.second->siduls;
+            for (unsigned int idx = 0; idx < siduls.size(); ++idx)
+                for (unsigned int instance = siduls.begin(idx); instance < siduls.end(idx); ++instance)
+                    sequenceUtilities[siduls.sids[idx]] += siduls.utility[instance];
+        }
+    }
+
+    std::vector<std::shared_ptr<Pattern>> candidates;
+    std::vector<char> isKept(state.sequenceSizes.size(), false);
+    numItems = kept.size();
+    for (auto &item : kept) {
+        for (auto sid : item.second->siduls.sids) isKept[sid] = true;
+        if (deltaItems.count(item.first)) candidates.push_back(item.second);
+    }
+    numSequences = std::count(isKept.begin(), isKept.end(), true);
+
+    MiningContext context = construct_context(state.sequenceSizes, std::move(candidates));
+    context.firstSid = firstSid;
+    return context;
+}
@@ -0,0 +1,93 @@
+/*
+    State of a mining run kept for incremental mining, all fields in native byte order:
+
+        StateHeader
+        float    utilities[numSequences]       sequence utilities
+        uint32_t sizes[numSequences]           number of itemsets of each sequence
+        numItems times, the SIDUL of an item over the loaded sequences:
+            int32_t  id
+            uint32_t numSids, numInstances
+            uint32_t sids[numSids]
+            uint32_t offsets[numSids + 1]
+            float    utility[numInstances], rem[numInstances]
+            uint32_t position[numInstances]
+            float    umin, RBU
+            uint32_t SE, SLIP
+        numPatterns times, a closed pattern of the output:
+            uint32_t length, support
+            float    umin
+            int32_t  items[length]
+
+    Item SIDULs are those of the sequences as loaded, before WPS_by_LRU_and_Support, since items
+    it prunes may be kept once more sequences are appended. Their remaining utilities are then
+    only looser upper bounds than after pruning, the patterns found and their metrics are the same.
+*/
+#pragma once
+#include <string>
+#include <unordered_map>
+#include "models.h"
+#include "store.h"
+
+const char STATE_MAGIC[8] = {'P', 'F', 'C', 'H', 'U', 'S', 'S', 'T'};
+const uint32_t STATE_VERSION = 1;
+
+class StateHeader {
+    public:
+        char magic[8];
+        uint32_t version;
+        float minSupport;
+        float minUtility;
+        uint32_t numItems;
+        uint64_t numSequences;
+        uint64_t numPatterns;
+};
+
+class MiningState {
+    public:
+        float minSupport;
+        float minUtility;
+        std::vector<float> sequenceUtilities;
+        std::vector<unsigned int> sequenceSizes;
+        std::unordered_map<unsigned int, std::shared_ptr<Pattern>> items;
+        std::vector<FCloPattern> patterns;
+};
+
+MiningState readState(const std::string &path);
+/*
+    The state is written next to path and renamed over it once complete
+*/
+void writeState(const MiningState &state, const std::string &path);
+/*
+    Closed patterns of the state occurring in none of the delta sequences. Their support and
+    utility cannot change, nor can their closedness since a superpattern with the same support
+    occurs in the same sequences, so they are still part of the output as they are.
+*/
+std::vector<FCloPattern> unaffected_patterns(
+    const MiningState &state,
+    const Database &delta,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &deltaItems
+);
+/*
+    Append the delta sequences to the state, numbered after the ones it holds, and their
+    instances to the item SIDULs
+*/
+void append_delta(
+    MiningState &state,
+    const Database &delta,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &deltaItems
+);
+/*
+    Context of the search over the state once the delta is appended, whose first sequence is
+    firstSid. The items kept are those shrink_database would keep over all the sequences,
+    counted in numItems along with the sequences they leave non-empty in numSequences, but only
+    the ones occurring in the delta are candidates of the search.
+*/
+MiningContext construct_context(
+    const MiningState &state,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &deltaItems,
+    unsigned int firstSid,
+    float MIN_SUPP,
+    float MIN_UTILITY,
+    unsigned int &numItems,
+    unsigned int &numSequences
+);
@@ -0,0 +1,84 @@
+#include <sys/resource.h>
+#include "omp.h"
+#include "stats.h"
+
+ThreadStats& ThreadStats::operator+=(const ThreadStats &other) {
+    this->nodes += other.nodes;
+    this->candidates += other.candidates;
+    this->iExtensions += other.iExtensions;
+    this->sExtensions += other.sExtensions;
+    this->rejectedByBitmap += other.rejectedByBitmap;
+    this->prunedByExtension += other.prunedByExtension;
+    this->prunedByRBU += other.prunedByRBU;
+    this->skippedBySE += other.skippedBySE;
+    this->prunedBySLIP += other.prunedBySLIP;
+    this->insertions += other.insertions;
+    this->evictions += other.evictions;
+    this->syncTime += other.syncTime;
+    this->lockWait += other.lockWait;
+    return *this;
+}
+
+SearchStats::SearchStats(unsigned int numThreads) : threads(numThreads) {}
+
+ThreadStats& SearchStats::local() {
+    return this->threads[omp_get_thread_num()];
+}
+
+ThreadStats SearchStats::total() const {
+    ThreadStats total;
+    for (auto &thread : this->threads) total += thread;
+    return total;
+}
+
+static void writeCounters(std::ostream &out, const ThreadStats &stats, const char *indent) {
+    out << indent << "\"nodes\": " << stats.nodes << ",\n" <<
+    indent << "\"candidates\": " << stats.candidates << ",\n" <<
+    indent << "\"i_extensions\": " << stats.iExtensions << ",\n" <<
+    indent << "\"s_extensions\": " << stats.sExtensions << ",\n" <<
+    indent << "\"rejected_by_bitmap\": " << stats.rejectedByBitmap << ",\n" <<
+    indent << "\"pruned_by_extension\": " << stats.prunedByExtension << ",\n" <<
+    indent << "\"pruned_by_rbu\": " << stats.prunedByRBU << ",\n" <<
+    indent << "\"skipped_by_se\": " << stats.skippedBySE << ",\n" <<
+    indent << "\"pruned_by_slip\": " << stats.prunedBySLIP << ",\n" <<
+    indent << "\"insertions\": " << stats.insertions << ",\n" <<
+    indent << "\"evictions\": " << stats.evictions << ",\n" <<
+    indent << "\"sync_time\": " << stats.syncTime << ",\n" <<
+    indent << "\"lock_wait\": " << stats.lockWait;
+}
+
+void SearchStats::writeJSON(std::ostream &out) const {
+    out << "{\n  \"threads\": " << this->threads.size() << ",\n";
+    out << "  \"peak_rss_kb\": " << peakRSS() << ",\n";
+    out << "  \"utility\": \"" << this->utility << "\",\n";
+    out << "  \"utility_scale\": " << this->utilityScale << ",\n";
+    out << "  \"position_bits\": " << this->positionBits << ",\n";
+    out << "  \"sid_bits\": " << this->sidBits << ",\n";
+    out << "  \"kernels\": \"" << this->kernels << "\",\n";
+    out << "  \"memory_limit_kb\": " << this->memoryLimit / 1024 << ",\n";
+    out << "  \"memory_peak_kb\": " << this->memoryPeak / 1024 << ",\n";
+    out << "  \"checkpoints\": " << this->checkpoints << ",\n";
+    out << "  \"resumed_roots\": " << this->resumedRoots << ",\n";
+    out << "  \"time\": {\n" <<
+    "    \"load\": " << this->phases.load << ",\n" <<
+    "    \"wps\": " << this->phases.wps << ",\n" <<
+    "    \"construct_siduls\": " << this->phases.constructSiduls << ",\n" <<
+    "    \"context\": " << this->phases.context << ",\n" <<
+    "    \"search\": " << this->phases.search << ",\n" <<
+    "    \"output\": " << this->phases.output << "\n  },\n";
+    out << "  \"total\": {\n";
+    writeCounters(out, this->total(), "    ");
+    out << "\n  },\n  \"per_thread\": [";
+    for (unsigned int thread = 0; thread < this->threads.size(); ++thread) {
+        out << (thread ? ", {\n" : "{\n");
+        writeCounters(out, this->threads[thread], "    ");
+        out << "\n  }";
+    }
+    out << "]\n}" << std::endl;
+}
+
+long peakRSS() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
@@ -0,0 +1,93 @@
+/*
+    Counters of a mining run. Each thread only updates its own slot, padded to a cache line so
+    that threads never share one, and slots are summed up once the search is over.
+
+    A slot is looked up by the thread currently running a task. An untied task may resume on
+    another thread, but only at a scheduling point, never between the lookup and the update.
+*/
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class alignas(64) ThreadStats {
+    public:
+        uint64_t nodes = 0;
+        uint64_t candidates = 0;
+        uint64_t iExtensions = 0;
+        uint64_t sExtensions = 0;
+        /*
+            Candidates rejected by the sid bitmaps alone, a subset of prunedByExtension
+        */
+        uint64_t rejectedByBitmap = 0;
+        uint64_t prunedByExtension = 0;
+        uint64_t prunedByRBU = 0;
+        /*
+            Closure rules: s-extensions skipped by SE, subtrees pruned by SE and SLIP
+        */
+        uint64_t skippedBySE = 0;
+        uint64_t prunedBySLIP = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        /*
+            Time in the closed-set insertion, of which lockWait was spent waiting for the lock
+        */
+        double syncTime = 0;
+        double lockWait = 0;
+
+        ThreadStats& operator+=(const ThreadStats &other);
+};
+
+/*
+    Wall-clock time of the phases of a run, in seconds
+*/
+class PhaseTimes {
+    public:
+        double load = 0;
+        double wps = 0;
+        double constructSiduls = 0;
+        double context = 0;
+        double search = 0;
+        double output = 0;
+};
+
+class SearchStats {
+    public:
+        std::vector<ThreadStats> threads;
+        PhaseTimes phases;
+        /*
+            Type of the utilities of the search, counted in units of 1/utilityScale
+        */
+        std::string utility = "float";
+        double utilityScale = 1;
+        /*
+            Widths of the positions and sequence ids of the search SIDULs
+        */
+        unsigned int positionBits = 32;
+        unsigned int sidBits = 32;
+        /*
+            Set of metric kernels the CPU runs, see metrics.h
+        */
+        std::string kernels = "scalar";
+        /*
+            Memory budget of the search in bytes and the most it held, 0 without one
+        */
+        uint64_t memoryLimit = 0;
+        uint64_t memoryPeak = 0;
+        /*
+            Checkpoints written by the search, and subtrees a resumed search skipped
+        */
+        unsigned int checkpoints = 0;
+        unsigned int resumedRoots = 0;
+
+        SearchStats(unsigned int numThreads);
+        ThreadStats& local();
+        ThreadStats total() const;
+        void writeJSON(std::ostream &out) const;
+};
+
+/*
+    Peak resident set size of the process in KB
+*/
+long peakRSS();
@@ -0,0 +1,261 @@
+#include "store.h"
+#include "utils.h"
+
+template <typename Utility>
+BasicFCloPattern<Utility>::BasicFCloPattern() {
+    this->size = 0;
+    this->support = 0;
+    this->umin = 0;
+    this->SE = 0;
+    this->SLIP = 0;
+}
+
+template <typename Utility>
+template <typename Position, typename Sid>
+BasicFCloPattern<Utility>::BasicFCloPattern(const BasicPattern<Utility, Position, Sid> &pattern) : items(pattern.items.begin(), pattern.items.end()) {
+    this->size = pattern.size;
+    this->support = pattern.siduls.size();
+    this->umin = pattern.umin;
+    this->SE = pattern.SE;
+    this->SLIP = pattern.SLIP;
+}
+
+template <typename Utility>
+FCloSublist<Utility>::FCloSublist() {
+    this->pattern_max_size = 0;
+    this->maxUmin = std::numeric_limits<Utility>::lowest();
+}
+
+template <typename Utility>
+UtilityThreshold<Utility>::UtilityThreshold(Utility minUtility, unsigned int k) : value(minUtility), k(k) {
+    omp_init_lock(&this->lock);
+}
+
+template <typename Utility>
+UtilityThreshold<Utility>::~UtilityThreshold() {
+    omp_destroy_lock(&this->lock);
+}
+
+template <typename Utility>
+Utility UtilityThreshold<Utility>::get() const {
+    return this->value.load(std::memory_order_relaxed);
+}
+
+template <typename Utility>
+unsigned int UtilityThreshold<Utility>::topK() const {
+    return this->k;
+}
+
+/*
+    The entry of the sublist, if it has one, is replaced. Removing another sublist's entry with
+    the same value instead leaves it to stand for that one, so entries still belong to distinct
+    sublists. The threshold only ever rises, since entries are only replaced by higher ones.
+*/
+template <typename Utility>
+void UtilityThreshold<Utility>::offer(Utility previous, Utility current) {
+    if (this->k == 0) return;
+    omp_set_lock(&this->lock);
+    auto entry = this->best.find(previous);
+    if (entry != this->best.end()) this->best.erase(entry);
+    this->best.insert(current);
+    if (this->best.size() > this->k) this->best.erase(this->best.begin());
+    if (this->best.size() == this->k && *this->best.begin() > this->get())
+        this->value.store(*this->best.begin(), std::memory_order_relaxed);
+    omp_unset_lock(&this->lock);
+}
+
+template <typename Utility>
+FCloShard<Utility>::FCloShard() {
+    for (unsigned int stripe = 0; stripe < STRIPES; ++stripe) omp_init_lock(&this->locks[stripe]);
+}
+
+template <typename Utility>
+FCloShard<Utility>::~FCloShard() {
+    for (unsigned int stripe = 0; stripe < STRIPES; ++stripe) omp_destroy_lock(&this->locks[stripe]);
+}
+
+template <typename Utility>
+FCloStore<Utility>::FCloStore(unsigned int maxSupport, UtilityThreshold<Utility> &minUtility) : shards(maxSupport + 1), minUtility(minUtility) {
+    for (auto &shard : this->shards) shard.store(nullptr, std::memory_order_relaxed);
+}
+
+template <typename Utility>
+FCloStore<Utility>::~FCloStore() {
+    for (auto &shard : this->shards) delete shard.load(std::memory_order_relaxed);
+}
+
+/*
+    Shards are only allocated for supports that actually occur. Concurrent first
+    accesses race on the slot, the loser frees its copy and uses the winner's.
+*/
+template <typename Utility>
+FCloShard<Utility>* FCloStore<Utility>::shard(unsigned int support) {
+    FCloShard<Utility> *current = this->shards[support].load(std::memory_order_acquire);
+    if (current) return current;
+    FCloShard<Utility> *created = new FCloShard<Utility>();
+    if (this->shards[support].compare_exchange_strong(current, created, std::memory_order_acq_rel)) return created;
+    delete created;
+    return current;
+}
+
+template <typename Utility>
+template <typename Position, typename Sid>
+bool FCloStore<Utility>::insert(const BasicPattern<Utility, Position, Sid> &pattern, bool &do_s_ext, bool &isPruned, uint64_t &evicted, double &lockWait) {
+    const uint64_t key = sidsHash(pattern.siduls);
+    const unsigned int stripe = key % FCloShard<Utility>::STRIPES;
+    FCloShard<Utility> *support = this->shard(pattern.siduls.size());
+    bool isClosed = true;
+
+    const double waitStart = omp_get_wtime();
+    omp_set_lock(&support->locks[stripe]);
+    lockWait += omp_get_wtime() - waitStart;
+    FCloSublist<Utility> &sublist = support->sublists[stripe][key];
+    /*
+        Since the pattern_max_size >= the size of the current candidate, there exists both
+        closed patterns whose size is either (1) >= or (2) < the size of the candidate.
+
+        Do this until all closed patterns are considered or we confirm that the new
+        pattern is not closed.
+    */
+    if (!(sublist.pattern_max_size < pattern.size)) {
+        auto it = sublist.cloPatterns.begin();
+        while (isClosed && (it != sublist.cloPatterns.end())) {
+            /*
+                (1)
+            */
+            if (
+                (it->size >= pattern.size) &&
+                (it->items.size() >= pattern.items.size())
+            ) {
+                if (isContainedBy(it->items, pattern.items)) {
+                    isClosed = false;
+                    if (it->SE == pattern.SE) {
+                        do_s_ext = false;
+                        if (it->SLIP == pattern.SLIP) isPruned = true;
+                    }
+                }
+                /*
+                    When the size is bigger but the candidate is not a subpattern,
+                    continue consider other closed patterns
+                */
+                else ++it;
+            }
+            /*
+                (2)
+            */
+            else {
+                if (isContainedBy(pattern.items, it->items)) {
+                    it = sublist.cloPatterns.erase(it);
+                    ++evicted;
+                }
+                else ++it;
+            }
+        }
+        if (isClosed) {
+            sublist.cloPatterns.emplace_back(pattern);
+            sublist.pattern_max_size = std::max(sublist.pattern_max_size, pattern.size);
+        }
+    }
+    /*
+        The size of all closed patterns in this sublist are less than that of the new candidate
+        -> The candidate becomes a closed pattern
+
+        We go back and eliminate existing closed patterns if any
+    */
+    else {
+        const size_t stored = sublist.cloPatterns.size();
+        sublist.cloPatterns.remove_if([&](const BasicFCloPattern<Utility> &it) {
+            return isContainedBy(pattern.items, it.items);
+        });
+        evicted += stored - sublist.cloPatterns.size();
+        sublist.cloPatterns.emplace_back(pattern);
+        sublist.pattern_max_size = pattern.size;
+    }
+    if (isClosed && pattern.umin > sublist.maxUmin) {
+        this->minUtility.offer(sublist.maxUmin, pattern.umin);
+        sublist.maxUmin = pattern.umin;
+    }
+    omp_unset_lock(&support->locks[stripe]);
+
+    return isClosed;
+}
+
+/*
+    Only to be called once all the tasks inserting patterns have completed.
+*/
+template <typename Utility>
+std::vector<const BasicFCloPattern<Utility>*> FCloStore<Utility>::patterns() {
+    std::vector<const BasicFCloPattern<Utility>*> cloPatterns;
+    for (auto &shard : this->shards) {
+        FCloShard<Utility> *support = shard.load(std::memory_order_acquire);
+        if (!support) continue;
+        for (unsigned int stripe = 0; stripe < FCloShard<Utility>::STRIPES; ++stripe)
+            for (auto &sublist : support->sublists[stripe])
+                for (auto &cloPattern : sublist.second.cloPatterns) cloPatterns.push_back(&cloPattern);
+    }
+    return cloPatterns;
+}
+
+template <typename Utility>
+std::vector<StoredPattern<Utility>> FCloStore<Utility>::copy(const std::function<bool(const BasicFCloPattern<Utility> &)> &isCopied) {
+    std::vector<StoredPattern<Utility>> copied;
+    for (auto &shard : this->shards) {
+        FCloShard<Utility> *support = shard.load(std::memory_order_acquire);
+        if (!support) continue;
+        for (unsigned int stripe = 0; stripe < FCloShard<Utility>::STRIPES; ++stripe) {
+            omp_set_lock(&support->locks[stripe]);
+            for (auto &sublist : support->sublists[stripe])
+                for (auto &cloPattern : sublist.second.cloPatterns)
+                    if (isCopied(cloPattern)) copied.push_back({sublist.first, cloPattern});
+            omp_unset_lock(&support->locks[stripe]);
+        }
+    }
+    return copied;
+}
+
+template <typename Utility>
+void FCloStore<Utility>::restore(const StoredPattern<Utility> &stored) {
+    const unsigned int stripe = stored.key % FCloShard<Utility>::STRIPES;
+    FCloShard<Utility> *support = this->shard(stored.pattern.support);
+    omp_set_lock(&support->locks[stripe]);
+    FCloSublist<Utility> &sublist = support->sublists[stripe][stored.key];
+    sublist.cloPatterns.push_back(stored.pattern);
+    sublist.pattern_max_size = std::max(sublist.pattern_max_size, stored.pattern.size);
+    if (stored.pattern.umin > sublist.maxUmin) {
+        this->minUtility.offer(sublist.maxUmin, stored.pattern.umin);
+        sublist.maxUmin = stored.pattern.umin;
+    }
+    omp_unset_lock(&support->locks[stripe]);
+}
+
+/*
+    FNV-1a over the sorted sequence ids, the high half is folded in since stripes use the low bits.
+*/
+template <typename Utility, typename Position, typename Sid>
+uint64_t sidsHash(const BasicSidul<Utility, Position, Sid> &siduls) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto sid : siduls.sids) {
+        hash ^= sid;
+        hash *= 1099511628211ULL;
+    }
+    return hash ^ (hash >> 32);
+}
+
+template class BasicFCloPattern<float>;
+template class BasicFCloPattern<int32_t>;
+template class BasicFCloPattern<int64_t>;
+template class UtilityThreshold<float>;
+template class UtilityThreshold<int32_t>;
+template class UtilityThreshold<int64_t>;
+template class FCloStore<float>;
+template class FCloStore<int32_t>;
+template class FCloStore<int64_t>;
+
+#define INSTANTIATE(Utility, Position, Sid) \
+    template BasicFCloPattern<Utility>::BasicFCloPattern(const BasicPattern<Utility, Position, Sid> &pattern); \
+    template bool FCloStore<Utility>::insert( \
+        const BasicPattern<Utility, Position, Sid> &pattern, bool &do_s_ext, bool &isPruned, uint64_t &evicted, double &lockWait \
+    ); \
+    template uint64_t sidsHash(const BasicSidul<Utility, Position, Sid> &siduls);
+SEARCH_LAYOUTS(INSTANTIATE)
+#undef INSTANTIATE
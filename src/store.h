@@ -0,0 +1,155 @@
+/*
+    The closed patterns found so far are partitioned by the support and,
+    within a support, by the set of sequences containing them.
+
+    A pattern can only be made non-closed by a superpattern with the same
+    support, and such a superpattern appears in exactly the same sequences.
+    Candidates with a different support or a different sequence set can
+    therefore never interact, so every partition is guarded by its own lock
+    and threads only contend when they hit the same one.
+
+    Each sublist keeps the max size of its patterns. When there's a new
+    candidate pattern that its size is bigger than the max size of the
+    sublist, skip checking since its obviously a new close pattern (it does
+    not have superpatterns with the same support). Otherwise, we need to
+    scan the list to check for both conditions.
+*/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <set>
+#include <vector>
+#include <unordered_map>
+#include "omp.h"
+#include "models.h"
+
+/*
+    A closed pattern outlives the search node, and the arena, it was built in. It is copied
+    out without its SIDUL, only keeping what closedness checks and the output need.
+*/
+template <typename Utility>
+class BasicFCloPattern {
+    public:
+        std::pmr::vector<int> items;
+        unsigned int size;
+        unsigned int support;
+        Utility umin;
+        unsigned int SE;
+        unsigned int SLIP;
+
+        BasicFCloPattern();
+        template <typename Position, typename Sid>
+        BasicFCloPattern(const BasicPattern<Utility, Position, Sid> &pattern);
+};
+
+using FCloPattern = BasicFCloPattern<float>;
+
+/*
+    A closed pattern copied out of a store with the key of its sublist, from which it is
+    stored again in another run (see checkpoint.h)
+*/
+template <typename Utility>
+class StoredPattern {
+    public:
+        uint64_t key;
+        BasicFCloPattern<Utility> pattern;
+};
+
+/*
+    maxUmin is the highest utility of a closed pattern ever stored in the sublist. A stored
+    pattern is only removed by a superpattern with the same support, whose utility is at least
+    as high, so the sublist always keeps a closed pattern with a utility of maxUmin or more.
+*/
+template <typename Utility>
+class FCloSublist {
+    public:
+        unsigned int pattern_max_size;
+        Utility maxUmin;
+        std::list<BasicFCloPattern<Utility>> cloPatterns;
+
+        FCloSublist();
+};
+
+/*
+    Minimum utility of the search, read by every search node without locking.
+
+    With k > 0 it is raised as closed patterns are found, to the k-th highest utility among
+    the sublists of the store, each counted once with its maxUmin. Every sublist ends up with
+    a closed pattern of at least that utility, so k patterns at or above the threshold are
+    always found, while the search prunes against it as if it had been given up front.
+*/
+template <typename Utility>
+class UtilityThreshold {
+    public:
+        UtilityThreshold(Utility minUtility, unsigned int k);
+        ~UtilityThreshold();
+        Utility get() const;
+        unsigned int topK() const;
+        /*
+            A sublist's maxUmin was raised from previous to current
+        */
+        void offer(Utility previous, Utility current);
+
+    private:
+        std::atomic<Utility> value;
+        unsigned int k;
+        omp_lock_t lock;
+        /*
+            The k highest sublist utilities, smallest first
+        */
+        std::multiset<Utility> best;
+};
+
+template <typename Utility>
+class FCloShard {
+    public:
+        /*
+            Sublists of a support are striped by the hash of their sequence set
+        */
+        static const unsigned int STRIPES = 16;
+
+        omp_lock_t locks[STRIPES];
+        std::unordered_map<uint64_t, FCloSublist<Utility>> sublists[STRIPES];
+
+        FCloShard();
+        ~FCloShard();
+};
+
+/*
+    Instantiated for the utility types of fixed.h, insert for the SEARCH_LAYOUTS of models.h
+*/
+template <typename Utility>
+class FCloStore {
+    public:
+        FCloStore(unsigned int maxSupport, UtilityThreshold<Utility> &minUtility);
+        ~FCloStore();
+        /*
+            Check whether the candidate is closed against the stored patterns, removing the ones
+            it subsumes, whose number is added to evicted. do_s_ext and isPruned are cleared/set
+            by the SE and SLIP rules. The time spent waiting for the lock is added to lockWait.
+        */
+        template <typename Position, typename Sid>
+        bool insert(const BasicPattern<Utility, Position, Sid> &pattern, bool &do_s_ext, bool &isPruned, uint64_t &evicted, double &lockWait);
+        std::vector<const BasicFCloPattern<Utility>*> patterns();
+        /*
+            Copy of the stored patterns isCopied selects, taken one stripe at a time under its
+            lock while the search goes on
+        */
+        std::vector<StoredPattern<Utility>> copy(const std::function<bool(const BasicFCloPattern<Utility> &)> &isCopied);
+        /*
+            Store a pattern copied out of a closed set of the same search, which none of the
+            stored ones subsumes nor is subsumed by
+        */
+        void restore(const StoredPattern<Utility> &stored);
+
+    private:
+        std::vector<std::atomic<FCloShard<Utility>*>> shards;
+        UtilityThreshold<Utility> &minUtility;
+
+        FCloShard<Utility>* shard(unsigned int support);
+};
+
+template <typename Utility, typename Position, typename Sid>
+uint64_t sidsHash(const BasicSidul<Utility, Position, Sid> &siduls);
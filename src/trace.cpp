@@ -0,0 +1,69 @@
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include "omp.h"
+#include "trace.h"
+#include "utils.h"
+
+Tracer::Tracer(unsigned int numThreads) : buffers(numThreads) {
+    this->origin = omp_get_wtime();
+}
+
+double Tracer::now() const {
+    return omp_get_wtime() - this->origin;
+}
+
+TraceBuffer& Tracer::local() {
+    return this->buffers[omp_get_thread_num()];
+}
+
+void Tracer::endTask(const TracedTask &task) {
+    const std::string name = pattern_to_string(this->originalIds.empty() ? task.items : restore_items(task.items, this->originalIds));
+    this->local().events.push_back({name, task.start, this->now(), task.depth, task.support, task.nodes, task.lockWait, task.thread});
+}
+
+void Tracer::phase(const std::string &name, double start) {
+    this->local().events.push_back({name, start - this->origin, this->now(), -1, 0, 0, 0, omp_get_thread_num()});
+}
+
+/*
+    Timestamps of the trace-event format are in microseconds. Events are listed under the thread
+    they started on, whichever buffer holds them.
+*/
+void Tracer::write(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("cannot write " + path);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    std::vector<std::vector<const TraceEvent*>> threads(this->buffers.size());
+    for (auto &buffer : this->buffers)
+        for (auto &event : buffer.events) threads[event.thread].push_back(&event);
+    bool first = true;
+    for (unsigned int thread = 0; thread < threads.size(); ++thread) {
+        out << (first ? "" : ",\n") <<
+        "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << thread <<
+        ", \"args\": {\"name\": \"thread " << thread << "\"}}";
+        first = false;
+        for (auto recorded : threads[thread]) {
+            const TraceEvent &event = *recorded;
+            out << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"" << (event.depth < 0 ? "phase" : "task") <<
+            "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << thread <<
+            ", \"ts\": " << event.start * 1e6 << ", \"dur\": " << (event.end - event.start) * 1e6;
+            if (event.depth >= 0) out << ", \"args\": {\"depth\": " << event.depth << ", \"support\": " << event.support <<
+                ", \"nodes\": " << event.nodes << ", \"lock_wait_us\": " << event.lockWait * 1e6 << "}";
+            out << "}";
+        }
+    }
+    out << "\n]}" << std::endl;
+}
+
+TracedTask::TracedTask(Tracer *tracer, const std::pmr::vector<int> &items, unsigned int support, int depth) :
+    tracer(tracer), items(items), support(support), depth(depth) {
+    if (!tracer) return;
+    this->start = tracer->now();
+    this->thread = omp_get_thread_num();
+}
+
+TracedTask::~TracedTask() {
+    if (this->tracer) this->tracer->endTask(*this);
+}
@@ -0,0 +1,90 @@
+/*
+    Timeline of the search tasks in the Chrome trace-event format, which chrome://tracing and
+    ui.perfetto.dev open directly.
+
+    Every task running a subtree of the search records one complete event, on the thread it
+    started on, with the depth and support of its root pattern, the nodes it explored inline and
+    the time they spent waiting for the closed-set lock. Search tasks are untied, so these are
+    counted by the task itself and follow it to whatever thread resumes it. Tasks spawned by a
+    task show up nested in it when they run within its taskwait. Events go to a buffer of the
+    thread ending them and are only gathered and written out at the end.
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include "models.h"
+
+class TraceEvent {
+    public:
+        std::string name;
+        double start;
+        double end;
+        int depth;
+        unsigned int support;
+        uint64_t nodes;
+        double lockWait;
+        int thread;
+};
+
+class alignas(64) TraceBuffer {
+    public:
+        std::vector<TraceEvent> events;
+};
+
+class TracedTask;
+
+class Tracer {
+    public:
+        Tracer(unsigned int numThreads);
+        /*
+            Seconds since the tracer was created
+        */
+        double now() const;
+        void endTask(const TracedTask &task);
+        /*
+            A phase of the run that started at the omp_get_wtime() timestamp start, recorded on
+            the calling thread with depth -1
+        */
+        void phase(const std::string &name, double start);
+        void write(const std::string &path) const;
+        /*
+            Original ids of the items when the search runs over renumbered ones
+        */
+        std::vector<int> originalIds;
+
+    private:
+        double origin;
+        std::vector<TraceBuffer> buffers;
+
+        TraceBuffer& local();
+};
+
+/*
+    Trace a task for the duration of the scope, when tracing is enabled. The task passes it down
+    its subtree to count the nodes it explores inline.
+*/
+class TracedTask {
+    public:
+        template <typename Utility, typename Position, typename Sid>
+        TracedTask(Tracer *tracer, const BasicPattern<Utility, Position, Sid> &pattern, int depth) :
+            TracedTask(tracer, pattern.items, pattern.siduls.size(), depth) {}
+        TracedTask(Tracer *tracer, const std::pmr::vector<int> &items, unsigned int support, int depth);
+        ~TracedTask();
+        /*
+            A search node was explored by the task, and waited for the closed-set lock for the
+            given time
+        */
+        void node() { ++this->nodes; }
+        void waited(double lockWait) { this->lockWait += lockWait; }
+
+    private:
+        friend class Tracer;
+        Tracer *tracer;
+        const std::pmr::vector<int> &items;
+        unsigned int support;
+        int depth;
+        double start;
+        int thread;
+        uint64_t nodes = 0;
+        double lockWait = 0;
+};
@@ -1,309 +1,597 @@
+#include "omp.h"
 #include "utils.h"
+#include "metrics.h"
 
 /*
-    Update the input data so that we only use one loop.
+    The data path is either a binary dataset file or a directory holding the two CSV files.
 */
-std::unordered_map<unsigned int, std::shared_ptr<Sequence>> readInputData(std::string inputDataPath) {
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences;
-
-    std::fstream sequencesFile (inputDataPath + "/" + SEQUENCES_FILE);
-    std::fstream utilitiesFile (inputDataPath + "/" + UTILITIES_FILE);
-
-    unsigned int seqID = 0;
-    std::string line;
-    std::vector<std::string> tokens;
-
-    while (std::getline(sequencesFile, line)) {
-        std::shared_ptr<Sequence> sequence = std::make_shared<Sequence>();
-        boost::split(tokens, line, boost::is_any_of("\t"));
-        for (int i = 0; i < tokens.size(); i++) {
-            int item = std::stoi(tokens[i]);
-            if (item == END_ITEMSET || item == END_SEQUENCE) ++sequence->size;
-            sequence->items.push_back(std::make_shared<Item>(item));
-        }
-        sequences[seqID] = sequence;
-
-        ++seqID;
-    }
-
-    seqID = 0;
-    while (std::getline(utilitiesFile, line)) {
-
-        unsigned int itemIdx = 0;
-        boost::split(tokens, line, boost::is_any_of("\t"));
-        for (auto const& token : tokens) {
-            float itemUtility = std::stof(token);
-            sequences[seqID]->items[itemIdx]->utility = itemUtility;
-            sequences[seqID]->utility += itemUtility;
-            ++itemIdx;
-        }
+Database readInputData(std::string inputDataPath) {
+    if (isBinaryData(inputDataPath)) return readBinaryData(inputDataPath);
+    return readCSVData(inputDataPath, nullptr);
+}
 
-        ++seqID;
+Database readInputData(std::string inputDataPath, std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems) {
+    if (isBinaryData(inputDataPath)) {
+        Database database = readBinaryData(inputDataPath);
+        sidulItems = construct_siduls(database);
+        return database;
     }
-
-    return sequences;
+    return readCSVData(inputDataPath, &sidulItems);
 }
 
-void print_sequences(std::unordered_map<int, Sequence> sequences) {
-    for (auto seq : sequences) {
-        std::cout << seq.first << "(" << seq.second.utility << "): ";
-        for (auto item : seq.second.items) std::cout << item->id << "/" << item->utility << " "; 
+void print_sequences(const Database &database) {
+    for (unsigned int seqID = 0; seqID < database.sequences.size(); ++seqID) {
+        std::cout << seqID << "(" << database.sequences[seqID].utility << "): ";
+        for (auto &item : database.sequences[seqID]) std::cout << item.id << "/" << item.utility << " "; 
         std::cout << std::endl;
     }
 }
 
 void print_pattern(Pattern pattern) {
-    std::cout << pattern.name << 
+    std::cout << pattern_to_string(pattern.items) << 
         ", lastItem: " << pattern.lastItem <<
         ", RBU: " << pattern.RBU <<
         ", umin: " << pattern.umin <<
         ", SE: " << pattern.SE <<
         ", SLIP: " << pattern.SLIP
         << std::endl;
-    for (auto seq : pattern.siduls) {
-        std::cout << seq.first << std::endl;
-        for (auto instance : seq.second) std::cout << instance->position << "/" << instance->utility << "/" << instance->rem << std::endl;
+    for (unsigned int idx = 0; idx < pattern.siduls.size(); ++idx) {
+        std::cout << pattern.siduls.sids[idx] << std::endl;
+        for (unsigned int instance = pattern.siduls.begin(idx); instance < pattern.siduls.end(idx); ++instance)
+            std::cout << pattern.siduls.position[instance] << "/" << pattern.siduls.utility[instance] << "/" << pattern.siduls.rem[instance] << std::endl;
         std::cout << std::endl;
     }
 }
 
+std::string pattern_to_string(const std::pmr::vector<int> &items) {
+    std::string name;
+    for (auto item : items) {
+        if (!name.empty()) name.push_back(' ');
+        name.append(std::to_string(item));
+    }
+    return name;
+}
+
 void print_siduls(std::unordered_map<int, Pattern> sidulItems) {
     std::cout << "# of items: " << sidulItems.size() << std::endl;
     for (auto item : sidulItems) {
         std::cout << "Item: " << item.first << std::endl;
-        for (auto seq : item.second.siduls) {
-            std::cout << "Seq: " << seq.first << ": ";
-            for (auto instance : seq.second)
-                std::cout << instance->position << "/" << instance->utility << "/" << instance->rem << "->";
+        const Sidul &siduls = item.second.siduls;
+        for (unsigned int idx = 0; idx < siduls.size(); ++idx) {
+            std::cout << "Seq: " << siduls.sids[idx] << ": ";
+            for (unsigned int instance = siduls.begin(idx); instance < siduls.end(idx); ++instance)
+                std::cout << siduls.position[instance] << "/" << siduls.utility[instance] << "/" << siduls.rem[instance] << "->";
             std::cout << std::endl;
         }
     }
 }
 
-std::unordered_map<unsigned int, std::shared_ptr<Pattern>> construct_siduls(
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences
-) {
+/*
+    Consecutive ranges of sequences with about the same number of records, a few per thread
+    so that uneven sequences still balance out. A single thread gets a single range, joining
+    ranges being pure overhead then.
+*/
+static std::vector<size_t> split_sequences(const Database &database) {
+    const size_t MIN_CHUNK_RECORDS = 1 << 14;
+    const unsigned int threads = omp_get_max_threads();
+    size_t numRecords = 0;
+    for (auto &sequence : database.sequences) numRecords += sequence.length;
+    const size_t numChunks = threads < 2 ? 1 : std::max<size_t>(1, std::min<size_t>(threads * 4, numRecords / MIN_CHUNK_RECORDS));
+    std::vector<size_t> bounds(1, 0);
+    size_t records = 0;
+    for (size_t seqID = 0; seqID < database.sequences.size(); ++seqID) {
+        records += database.sequences[seqID].length;
+        if (records * numChunks >= numRecords * bounds.size() && bounds.size() < numChunks) bounds.push_back(seqID + 1);
+    }
+    if (bounds.back() != database.sequences.size()) bounds.push_back(database.sequences.size());
+    return bounds;
+}
+
+std::unordered_map<unsigned int, std::shared_ptr<Pattern>> construct_siduls(const Database &database) {
+    /*
+        SIDULs keep their sequence ids in ascending order, so each chunk scans its sequences
+        by id and the chunks are joined in order.
+    */
+    const std::vector<size_t> bounds = split_sequences(database);
+    std::vector<std::unordered_map<unsigned int, std::shared_ptr<Pattern>>> fragments(bounds.size() - 1);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t chunk = 0; chunk < fragments.size(); ++chunk)
+        for (size_t seqID = bounds[chunk]; seqID < bounds[chunk + 1]; ++seqID)
+            construct_siduls(fragments[chunk], seqID, database.sequences[seqID]);
     std::unordered_map<unsigned int, std::shared_ptr<Pattern>> sidulItems;
-    for (auto seq : sequences) {
-        /*
-
-        */
-        std::unordered_map<unsigned int, float> uminInSequence;
-
-        unsigned int itemsetIdx = 0;
-        float prefixUtility = 0;
-        for (auto item : seq.second->items) {
-            if (item->id != END_ITEMSET && item->id != END_SEQUENCE) {
-                if (sidulItems.find(item->id) == sidulItems.end()) {
-                    sidulItems[item->id] = std::make_shared<Pattern>();
-                    sidulItems[item->id]->lastItem = item->id;
-                    ++sidulItems[item->id]->size;
-                    /*
-                        If performance is all what we need, remove the name.
-                    */
-                    sidulItems[item->id]->name.append(std::to_string(item->id));
-                }
-                sidulItems[item->id]->siduls[seq.first].push_back(
-                    std::make_shared<ItemInstance>(
-                        item->utility,
-                        seq.second->utility - (prefixUtility += item->utility),
-                        itemsetIdx
-                    )
-                );
-                /*
-                    When an item first appears in a sequence, initialize its umin to max of float.
-                    We seek for the smallest umin among all of this instances.
-                */
-                if (uminInSequence.find(item->id) == uminInSequence.end()) uminInSequence[item->id] = std::numeric_limits<float>::max();
-                uminInSequence[item->id] = std::min(uminInSequence[item->id], item->utility);
-            } else ++itemsetIdx;
+    join_siduls(sidulItems, fragments, database);
+    return sidulItems;
+}
+
+void construct_siduls(
+    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    unsigned int seqID,
+    const Sequence &sequence
+) {
+    /*
+        Items appearing in this sequence, their metrics are updated once the whole sequence is scanned.
+    */
+    std::vector<std::shared_ptr<Pattern>> itemsInSequence;
+
+    unsigned int itemsetIdx = 0;
+    float prefixUtility = 0;
+    for (const auto &item : sequence) {
+        if (item.id != END_ITEMSET && item.id != END_SEQUENCE) {
+            std::shared_ptr<Pattern> &sidulItem = sidulItems[item.id];
+            if (!sidulItem) {
+                sidulItem = std::make_shared<Pattern>();
+                sidulItem->lastItem = item.id;
+                ++sidulItem->size;
+                sidulItem->items.push_back(item.id);
+            }
+            if (!sidulItem->siduls.size() || sidulItem->siduls.sids.back() != seqID) itemsInSequence.push_back(sidulItem);
+            sidulItem->siduls.addInstance(
+                seqID,
+                item.utility,
+                sequence.utility - (prefixUtility += item.utility),
+                itemsetIdx
+            );
+        } else ++itemsetIdx;
+    }
+    /*
+        The instances of an item in this sequence are the last ones of its SIDUL.
+    */
+    for (auto sidulItem : itemsInSequence) add_sequence_metrics(*sidulItem, sidulItem->siduls.size() - 1, sequence.size);
+}
+
+void add_sequence_metrics(Pattern &sidulItem, unsigned int idx, unsigned int sequenceSize) {
+    /*
+        We seek for the smallest umin among all of the instances in the sequence.
+    */
+    const Sidul &siduls = sidulItem.siduls;
+    float uminInSequence = std::numeric_limits<float>::max();
+    for (unsigned int instance = siduls.begin(idx); instance < siduls.end(idx); ++instance)
+        uminInSequence = std::min(uminInSequence, siduls.utility[instance]);
+    sidulItem.umin += uminInSequence;
+    sidulItem.RBU += (siduls.utility[siduls.begin(idx)] + siduls.rem[siduls.begin(idx)]);
+    sidulItem.SE += (sequenceSize - (siduls.position[siduls.begin(idx)]+1) + 1);
+    sidulItem.SLIP += siduls.end(idx) - siduls.begin(idx);
+}
+
+void join_siduls(
+    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    std::vector<std::unordered_map<unsigned int, std::shared_ptr<Pattern>>> &fragments,
+    const Database &database
+) {
+    /*
+        The first fragment of an item is taken over as is and the later ones are appended to
+        it. Items are independent and joined in parallel.
+    */
+    std::vector<std::pair<std::shared_ptr<Pattern>, size_t>> joinedItems;
+    for (size_t chunk = 0; chunk < fragments.size(); ++chunk)
+        for (auto &fragment : fragments[chunk]) {
+            std::shared_ptr<Pattern> &sidulItem = sidulItems[fragment.first];
+            if (!sidulItem) {
+                sidulItem = fragment.second;
+                joinedItems.push_back({sidulItem, chunk});
+            }
         }
-        for (auto item : uminInSequence) {
-            sidulItems[item.first]->umin += item.second;
-            sidulItems[item.first]->RBU += (sidulItems[item.first]->siduls[seq.first][0]->utility + sidulItems[item.first]->siduls[seq.first][0]->rem);
-            sidulItems[item.first]->SE += (sequences[seq.first]->size - (sidulItems[item.first]->siduls[seq.first][0]->position+1) + 1);
-            sidulItems[item.first]->SLIP += sidulItems[item.first]->siduls[seq.first].size();
+    /*
+        Sizes are gathered apart, the sequences themselves being too large to stay in cache
+    */
+    std::vector<unsigned int> sequenceSizes(database.sequences.size());
+    for (size_t seqID = 0; seqID < database.sequences.size(); ++seqID) sequenceSizes[seqID] = database.sequences[seqID].size;
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (size_t idx = 0; idx < joinedItems.size(); ++idx) {
+        Pattern &sidulItem = *joinedItems[idx].first;
+        bool isJoined = false;
+        for (size_t chunk = joinedItems[idx].second + 1; chunk < fragments.size(); ++chunk) {
+            auto fragment = fragments[chunk].find(sidulItem.lastItem);
+            if (fragment == fragments[chunk].end()) continue;
+            sidulItem.siduls.append(fragment->second->siduls);
+            isJoined = true;
         }
+        if (!isJoined) continue;
+        sidulItem.umin = 0;
+        sidulItem.RBU = 0;
+        sidulItem.SE = 0;
+        sidulItem.SLIP = 0;
+        add_sidul_metrics(sidulItem, 0, sequenceSizes.data());
     }
-    return sidulItems;
 }
 
-std::unordered_map<unsigned int, std::shared_ptr<Sequence>> WPS_by_LRU_and_Support(
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences,
-    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> sidulItems,
+void merge_siduls(Pattern &sidulItem, const Pattern &fragment, unsigned int sidOffset) {
+    sidulItem.siduls.append(fragment.siduls, sidOffset);
+    sidulItem.umin += fragment.umin;
+    sidulItem.RBU += fragment.RBU;
+    sidulItem.SE += fragment.SE;
+    sidulItem.SLIP += fragment.SLIP;
+}
+
+MiningContext construct_context(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems
+) {
+    std::vector<unsigned int> sequenceSizes;
+    std::vector<std::shared_ptr<Pattern>> items;
+    for (auto &sequence : database.sequences) sequenceSizes.push_back(sequence.size);
+    for (auto &item : sidulItems) items.push_back(item.second);
+    return construct_context(std::move(sequenceSizes), std::move(items));
+}
+
+MiningContext construct_context(std::vector<unsigned int> sequenceSizes, std::vector<std::shared_ptr<Pattern>> items) {
+    MiningContext context;
+    context.sequenceSizes = std::move(sequenceSizes);
+    context.items = std::move(items);
+    std::sort(
+        context.items.begin(),
+        context.items.end(),
+        [](const std::shared_ptr<Pattern> &a, const std::shared_ptr<Pattern> &b) { return a->lastItem < b->lastItem; }
+    );
+    context.itemBits.reserve(context.items.size());
+    for (auto &item : context.items) context.itemBits.emplace_back(item->siduls);
+    return context;
+}
+
+/*
+    Whether each item is kept, its LRU being summed over its sequences in ascending order of id
+*/
+static std::unordered_map<int, bool> keep_items(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
     float MIN_SUPP,
     float MIN_UTILITY
 ) {
-    std::unordered_map<int, float> LRUByItem;
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> updatedSequences;
-    for (auto seq : sequences) {
-        std::shared_ptr<Sequence> updatedSequence = std::make_shared<Sequence>();
+    std::vector<std::pair<int, const Pattern*>> items;
+    for (auto &item : sidulItems) items.push_back({item.first, item.second.get()});
+    std::vector<char> isItemKept(items.size());
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (size_t idx = 0; idx < items.size(); ++idx) {
+        const Sidul &siduls = items[idx].second->siduls;
+        float LRU = 0;
+        for (auto sid : siduls.sids) LRU += database.sequences[sid].utility;
+        isItemKept[idx] = siduls.size() >= MIN_SUPP && LRU >= MIN_UTILITY;
+    }
+    std::unordered_map<int, bool> isKept;
+    for (size_t idx = 0; idx < items.size(); ++idx) isKept[items[idx].first] = isItemKept[idx];
+    return isKept;
+}
+
+static Database prune_database(const Database &database, const std::unordered_map<int, bool> &isKept) {
+    /*
+        Sequences are pruned in parallel, a first pass finding the length of each pruned
+        sequence and a second one writing it at its place among the records
+    */
+    Database updatedDatabase;
+    updatedDatabase.sequences.resize(database.sequences.size());
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t seqID = 0; seqID < database.sequences.size(); ++seqID) {
+        Sequence &updatedSequence = updatedDatabase.sequences[seqID];
         bool itemAdded = false;
-        for (auto item : seq.second->items) {
-            if (item->id != END_ITEMSET && item->id != END_SEQUENCE) {
-                if (LRUByItem.find(item->id) == LRUByItem.end()) 
-                    for (auto seq : sidulItems[item->id]->siduls) LRUByItem[item->id] += sequences[seq.first]->utility;
-                if (sidulItems[item->id]->siduls.size() >= MIN_SUPP && LRUByItem[item->id] >= MIN_UTILITY) {
+        for (const auto &item : database.sequences[seqID]) {
+            if (item.id != END_ITEMSET && item.id != END_SEQUENCE) {
+                if (isKept.at(item.id)) {
                     itemAdded = true;
-                    updatedSequence->utility += item->utility;
-                    updatedSequence->items.push_back(item);
+                    ++updatedSequence.length;
                 }
-            } else {
-                if (itemAdded) {
-                    ++updatedSequence->size;
-                    itemAdded = false;
-                    updatedSequence->items.push_back(item);
+            } else if (itemAdded) {
+                itemAdded = false;
+                ++updatedSequence.length;
+            }
+        }
+    }
+    std::vector<size_t> firstRecords(database.sequences.size() + 1, 0);
+    for (size_t seqID = 0; seqID < database.sequences.size(); ++seqID)
+        firstRecords[seqID + 1] = firstRecords[seqID] + updatedDatabase.sequences[seqID].length;
+    updatedDatabase.records.resize(firstRecords.back());
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t seqID = 0; seqID < database.sequences.size(); ++seqID) {
+        Sequence &updatedSequence = updatedDatabase.sequences[seqID];
+        Item *record = updatedDatabase.records.data() + firstRecords[seqID];
+        bool itemAdded = false;
+        for (const auto &item : database.sequences[seqID]) {
+            if (item.id != END_ITEMSET && item.id != END_SEQUENCE) {
+                if (isKept.at(item.id)) {
+                    itemAdded = true;
+                    updatedSequence.utility += item.utility;
+                    *record++ = item;
                 }
+            } else if (itemAdded) {
+                ++updatedSequence.size;
+                itemAdded = false;
+                *record++ = item;
             }
         }
-        if (updatedSequence->items.size()) updatedSequences[seq.first] = updatedSequence;
     }
+    updatedDatabase.link(updatedDatabase.records.data());
 
-    return updatedSequences;
+    return updatedDatabase;
 }
 
-std::shared_ptr<Pattern> construct_i_ext(
-    std::shared_ptr<Pattern> pattern,
-    std::shared_ptr<Pattern> item, 
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences
+Database WPS_by_LRU_and_Support(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    float MIN_SUPP,
+    float MIN_UTILITY
 ) {
-    std::shared_ptr<Pattern> extendedPattern = std::make_shared<Pattern>();
-    extendedPattern->isSExt = false;
-    extendedPattern->lastItem = item->lastItem;
-    extendedPattern->parentLastItem = pattern->lastItem;
-    extendedPattern->isParentSExt = pattern->isSExt;
-    extendedPattern->name = pattern->name;
-    extendedPattern->name.append(" ").append(item->name);
-    extendedPattern->size = pattern->size;
-
-    std::unordered_set<unsigned int> commonSeqs;
-    for (auto seq : pattern->siduls) commonSeqs.insert(seq.first);
-    for (auto seq : item->siduls) {
-        float uminInSequence = std::numeric_limits<float>::max();
-        if (commonSeqs.find(seq.first) != commonSeqs.end()) {
-            std::unordered_map<unsigned int, unsigned int> commonPoss;
-            for (int idx = 0; idx < item->siduls[seq.first].size(); ++idx) 
-                commonPoss.insert({item->siduls[seq.first][idx]->position, idx});
-            for (auto patternInstance : pattern->siduls[seq.first])
-                if (commonPoss.find(patternInstance->position) != commonPoss.end()) {
-                    const float instanceUmin = patternInstance->utility + item->siduls[seq.first][commonPoss[patternInstance->position]]->utility;
-                    extendedPattern->siduls[seq.first].push_back(
-                        std::make_shared<ItemInstance>(
-                            instanceUmin,
-                            item->siduls[seq.first][commonPoss[patternInstance->position]]->rem,
-                            item->siduls[seq.first][commonPoss[patternInstance->position]]->position
-                        )
-                    );
-                    uminInSequence = std::min(uminInSequence, instanceUmin);
-                }
-            /*
-                When they both appear in the same sequence, but they do not share any common position(s).
-            */    
-            if (uminInSequence != std::numeric_limits<float>::max()) {
-                extendedPattern->umin += uminInSequence;
-                extendedPattern->RBU += (extendedPattern->siduls[seq.first][0]->utility + extendedPattern->siduls[seq.first][0]->rem);
-                extendedPattern->SE += (sequences[seq.first]->size - (extendedPattern->siduls[seq.first][0]->position+1) + 1);
-                extendedPattern->SLIP += extendedPattern->siduls[seq.first].size();
+    return prune_database(database, keep_items(database, sidulItems, MIN_SUPP, MIN_UTILITY));
+}
+
+Database shrink_database(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    float MIN_SUPP,
+    float MIN_UTILITY,
+    std::vector<int> &originalIds
+) {
+    /*
+        The LRU of an item only decreases from one round to the next, so items once removed
+        stay removed and the rounds stop as soon as the number of kept items stays the same
+    */
+    std::unordered_map<int, bool> isKept = keep_items(database, sidulItems, MIN_SUPP, MIN_UTILITY);
+    Database updatedDatabase = prune_database(database, isKept);
+    auto numKept = [](const std::unordered_map<int, bool> &isKept) {
+        return std::count_if(isKept.begin(), isKept.end(), [](const std::pair<const int, bool> &it) { return it.second; });
+    };
+    for (;;) {
+        std::unordered_map<int, bool> isStillKept = keep_items(updatedDatabase, sidulItems, MIN_SUPP, MIN_UTILITY);
+        if (numKept(isStillKept) == numKept(isKept)) break;
+        updatedDatabase = prune_database(updatedDatabase, isStillKept);
+        isKept = std::move(isStillKept);
+    }
+
+    std::vector<std::pair<unsigned int, int>> kept;
+    for (auto &item : isKept)
+        if (item.second) kept.push_back({sidulItems.at(item.first)->siduls.size(), item.first});
+    std::sort(kept.begin(), kept.end());
+    std::unordered_map<int, int> newIds;
+    originalIds.resize(kept.size());
+    for (size_t idx = 0; idx < kept.size(); ++idx) {
+        originalIds[idx] = kept[idx].second;
+        newIds[kept[idx].second] = idx;
+    }
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t seqID = 0; seqID < updatedDatabase.sequences.size(); ++seqID) {
+        const Sequence &sequence = updatedDatabase.sequences[seqID];
+        Item *itemset = updatedDatabase.records.data() + (sequence.items - updatedDatabase.records.data());
+        Item *end = itemset + sequence.length;
+        for (Item *record = itemset; record <= end; ++record) {
+            if (record < end && record->id != END_ITEMSET && record->id != END_SEQUENCE) {
+                record->id = newIds.at(record->id);
+                continue;
             }
+            std::sort(itemset, record, [](const Item &a, const Item &b) { return a.id < b.id; });
+            itemset = record + 1;
+        }
+    }
+    return updatedDatabase;
+}
+
+std::pmr::vector<int> restore_items(const std::pmr::vector<int> &items, const std::vector<int> &originalIds) {
+    std::pmr::vector<int> restored;
+    restored.reserve(items.size());
+    size_t itemset = 0;
+    for (auto item : items) {
+        if (item != END_ITEMSET) {
+            restored.push_back(originalIds[item]);
+            continue;
         }
+        std::sort(restored.begin() + itemset, restored.end());
+        restored.push_back(END_ITEMSET);
+        itemset = restored.size();
     }
-    return extendedPattern;
+    std::sort(restored.begin() + itemset, restored.end());
+    return restored;
 }
 
-std::shared_ptr<Pattern> construct_s_ext(
-    std::shared_ptr<Pattern> pattern,
-    std::shared_ptr<Pattern> item, 
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences
+/*
+    Size the extension's SIDUL for the worst case over the common sequences, so that it is
+    allocated once. An item instance yields at most one instance of an s-extension, and an
+    i-extension additionally has at most one instance per pattern instance.
+*/
+template <typename Utility, typename Position, typename Sid>
+static void reserve_extension(
+    BasicSidul<Utility, Position, Sid> &extendedSiduls,
+    const BasicSidul<Utility, Position, Sid> &patternSiduls,
+    const BasicSidul<Utility, Position, Sid> &itemSiduls,
+    bool isSExt
 ) {
-    std::shared_ptr<Pattern> extendedPattern = std::make_shared<Pattern>();
-    extendedPattern->lastItem = item->lastItem;
-    extendedPattern->isParentSExt = pattern->isSExt;
-    extendedPattern->parentLastItem = pattern->lastItem;
-    extendedPattern->name = pattern->name;
-    extendedPattern->name.append(" -1 ").append(item->name);
-    extendedPattern->size = pattern->size + 1;
-
-    std::unordered_set<unsigned int> commonSeqs;
-    for (auto seq : pattern->siduls) commonSeqs.insert(seq.first);
-    for (auto seq : item->siduls) {
-        float uminInSequence = std::numeric_limits<float>::max();
-        if (commonSeqs.find(seq.first) != commonSeqs.end()) {
-            for (auto itemInstance : item->siduls[seq.first]) {
-                float newUmin = std::numeric_limits<float>::max();
-                unsigned int patternInstanceIdx = 0;
-                auto patternInstance = pattern->siduls[seq.first][patternInstanceIdx];
-                while (patternInstance->position < itemInstance->position) {
-                        float currentUmin = patternInstance->utility + itemInstance->utility;
-                        newUmin = std::min(newUmin, currentUmin);
-                        /*
-                            Need to carefully handle the index, refs:
-                            https://stackoverflow.com/questions/27754726/no-compilation-error-or-run-time-error-when-index-out-of-range-of-vector-class
-                        */    
-                        if (++patternInstanceIdx >= pattern->siduls[seq.first].size()) break;          
-                        patternInstance = pattern->siduls[seq.first][patternInstanceIdx];
-                }
+    unsigned int sequences = 0, instances = 0;
+    unsigned int patternIdx = 0, itemIdx = 0;
+    while (patternIdx < patternSiduls.size() && itemIdx < itemSiduls.size()) {
+        if (patternSiduls.sids[patternIdx] < itemSiduls.sids[itemIdx]) ++patternIdx;
+        else if (patternSiduls.sids[patternIdx] > itemSiduls.sids[itemIdx]) ++itemIdx;
+        else {
+            const unsigned int itemInstances = itemSiduls.end(itemIdx) - itemSiduls.begin(itemIdx);
+            const unsigned int patternInstances = patternSiduls.end(patternIdx) - patternSiduls.begin(patternIdx);
+            ++sequences;
+            instances += isSExt ? itemInstances : std::min(itemInstances, patternInstances);
+            ++patternIdx;
+            ++itemIdx;
+        }
+    }
+    extendedSiduls.reserve(sequences, instances);
+}
+
+/*
+    The metrics of an extension are summed once its SIDUL is complete, over its columns rather
+    than instance by instance while merging.
+*/
+template <typename Utility, typename Position, typename Sid>
+void add_sidul_metrics(BasicPattern<Utility, Position, Sid> &pattern, unsigned int idx, const unsigned int *sequenceSizes) {
+    const BasicSidul<Utility, Position, Sid> &siduls = pattern.siduls;
+    const unsigned int count = siduls.size() - idx;
+    if (count == 0) return;
+    const unsigned int *offsets = siduls.offsets.data() + idx;
+    pattern.umin += sumMinima(siduls.utility.data(), offsets, count);
+    pattern.RBU += sumFirsts(siduls.utility.data(), siduls.rem.data(), offsets, count);
+    pattern.SE += sumExtents(siduls.position.data(), siduls.sids.data() + idx, offsets, sequenceSizes, count);
+    pattern.SLIP += countInstances(offsets, count);
+}
+
+template <typename Utility, typename Position, typename Sid>
+void construct_i_ext(
+    BasicPattern<Utility, Position, Sid> &extendedPattern,
+    const BasicPattern<Utility, Position, Sid> &pattern,
+    const BasicPattern<Utility, Position, Sid> &item,
+    const BasicMiningContext<Utility, Position, Sid> &context
+) {
+    extendedPattern.isSExt = false;
+    extendedPattern.lastItem = item.lastItem;
+    extendedPattern.parentLastItem = pattern.lastItem;
+    extendedPattern.isParentSExt = pattern.isSExt;
+    extendedPattern.items.reserve(pattern.items.size() + 1);
+    extendedPattern.items = pattern.items;
+    extendedPattern.items.push_back(item.lastItem);
+    extendedPattern.size = pattern.size;
 
-                if (newUmin != std::numeric_limits<float>::max()) {
-                    extendedPattern->siduls[seq.first].push_back(
-                        std::make_shared<ItemInstance>(
-                            newUmin,
-                            itemInstance->rem,
-                            itemInstance->position
-                        )
+    const BasicSidul<Utility, Position, Sid> &patternSiduls = pattern.siduls, &itemSiduls = item.siduls;
+    BasicSidul<Utility, Position, Sid> &extendedSiduls = extendedPattern.siduls;
+    reserve_extension(extendedSiduls, patternSiduls, itemSiduls, false);
+    /*
+        Both SIDULs are sorted by sequence id, common sequences are found by merging them.
+    */
+    unsigned int patternIdx = 0, itemIdx = 0;
+    while (patternIdx < patternSiduls.size() && itemIdx < itemSiduls.size()) {
+        if (patternSiduls.sids[patternIdx] < itemSiduls.sids[itemIdx]) ++patternIdx;
+        else if (patternSiduls.sids[patternIdx] > itemSiduls.sids[itemIdx]) ++itemIdx;
+        else {
+            const unsigned int sid = patternSiduls.sids[patternIdx];
+            /*
+                Instances of both are ordered by position and an itemset holds an item at most
+                once, so the instances at common positions are paired up by merging them.
+            */
+            unsigned int patternInstance = patternSiduls.begin(patternIdx), itemInstance = itemSiduls.begin(itemIdx);
+            const unsigned int patternEnd = patternSiduls.end(patternIdx), itemEnd = itemSiduls.end(itemIdx);
+            while (patternInstance < patternEnd && itemInstance < itemEnd) {
+                if (patternSiduls.position[patternInstance] < itemSiduls.position[itemInstance]) ++patternInstance;
+                else if (patternSiduls.position[patternInstance] > itemSiduls.position[itemInstance]) ++itemInstance;
+                else {
+                    const Utility instanceUmin = patternSiduls.utility[patternInstance] + itemSiduls.utility[itemInstance];
+                    extendedSiduls.addInstance(
+                        sid,
+                        instanceUmin,
+                        itemSiduls.rem[itemInstance],
+                        itemSiduls.position[itemInstance]
                     );
-                    uminInSequence = std::min(uminInSequence, newUmin);
+                    ++patternInstance;
+                    ++itemInstance;
                 }
             }
+            ++patternIdx;
+            ++itemIdx;
+        }
+    }
+    add_sidul_metrics(extendedPattern, 0, context.sequenceSizes.data());
+}
+
+template <typename Utility, typename Position, typename Sid>
+void construct_s_ext(
+    BasicPattern<Utility, Position, Sid> &extendedPattern,
+    const BasicPattern<Utility, Position, Sid> &pattern,
+    const BasicPattern<Utility, Position, Sid> &item,
+    const BasicMiningContext<Utility, Position, Sid> &context
+) {
+    extendedPattern.lastItem = item.lastItem;
+    extendedPattern.isParentSExt = pattern.isSExt;
+    extendedPattern.parentLastItem = pattern.lastItem;
+    extendedPattern.items.reserve(pattern.items.size() + 2);
+    extendedPattern.items = pattern.items;
+    extendedPattern.items.push_back(END_ITEMSET);
+    extendedPattern.items.push_back(item.lastItem);
+    extendedPattern.size = pattern.size + 1;
+
+    const BasicSidul<Utility, Position, Sid> &patternSiduls = pattern.siduls, &itemSiduls = item.siduls;
+    BasicSidul<Utility, Position, Sid> &extendedSiduls = extendedPattern.siduls;
+    reserve_extension(extendedSiduls, patternSiduls, itemSiduls, true);
+    unsigned int patternIdx = 0, itemIdx = 0;
+    while (patternIdx < patternSiduls.size() && itemIdx < itemSiduls.size()) {
+        if (patternSiduls.sids[patternIdx] < itemSiduls.sids[itemIdx]) ++patternIdx;
+        else if (patternSiduls.sids[patternIdx] > itemSiduls.sids[itemIdx]) ++itemIdx;
+        else {
+            const unsigned int sid = patternSiduls.sids[patternIdx];
             /*
-                When they both appear in the same sequence, but they do not share any common position(s).
+                An item instance extends the pattern instances at earlier positions, of which the
+                one with the least utility gives its umin. Item instances are visited by ascending
+                position, so this is the running minimum over a growing prefix of the pattern's.
             */
-            if (uminInSequence != std::numeric_limits<float>::max()) {
-                extendedPattern->umin += uminInSequence;
-                extendedPattern->RBU += (extendedPattern->siduls[seq.first][0]->utility + extendedPattern->siduls[seq.first][0]->rem);
-                extendedPattern->SE += (sequences[seq.first]->size - (extendedPattern->siduls[seq.first][0]->position+1) + 1);
-                extendedPattern->SLIP += extendedPattern->siduls[seq.first].size();
+            Utility prefixUmin = std::numeric_limits<Utility>::max();
+            unsigned int patternInstance = patternSiduls.begin(patternIdx);
+            const unsigned int patternEnd = patternSiduls.end(patternIdx);
+            for (unsigned int itemInstance = itemSiduls.begin(itemIdx); itemInstance < itemSiduls.end(itemIdx); ++itemInstance) {
+                for (; patternInstance < patternEnd && patternSiduls.position[patternInstance] < itemSiduls.position[itemInstance]; ++patternInstance)
+                    prefixUmin = std::min(prefixUmin, patternSiduls.utility[patternInstance]);
+
+                if (patternInstance != patternSiduls.begin(patternIdx)) {
+                    const Utility newUmin = prefixUmin + itemSiduls.utility[itemInstance];
+                    extendedSiduls.addInstance(
+                        sid,
+                        newUmin,
+                        itemSiduls.rem[itemInstance],
+                        itemSiduls.position[itemInstance]
+                    );
+                }
             }
+            ++patternIdx;
+            ++itemIdx;
         }
     }
-    return extendedPattern;
+    add_sidul_metrics(extendedPattern, 0, context.sequenceSizes.data());
 }
 
-float computeRBU(Pattern pattern) {
-    float patternRBU = 0;
-    for (auto sidul : pattern.siduls) patternRBU += (sidul.second[0]->utility + sidul.second[0]->rem);
-    return patternRBU;
+#define INSTANTIATE(Utility, Position, Sid) \
+    template void add_sidul_metrics(BasicPattern<Utility, Position, Sid> &, unsigned int, const unsigned int *); \
+    template void construct_i_ext( \
+        BasicPattern<Utility, Position, Sid> &, const BasicPattern<Utility, Position, Sid> &, \
+        const BasicPattern<Utility, Position, Sid> &, const BasicMiningContext<Utility, Position, Sid> & \
+    ); \
+    template void construct_s_ext( \
+        BasicPattern<Utility, Position, Sid> &, const BasicPattern<Utility, Position, Sid> &, \
+        const BasicPattern<Utility, Position, Sid> &, const BasicMiningContext<Utility, Position, Sid> & \
+    );
+SEARCH_LAYOUTS(INSTANTIATE)
+#undef INSTANTIATE
+
+float computeRBU(const Pattern &pattern) {
+    return sumFirsts(pattern.siduls.utility.data(), pattern.siduls.rem.data(), pattern.siduls.offsets.data(), pattern.siduls.size());
 }
 
-float computeUmin(Pattern pattern) {
-    float patternUmin = 0;
-    for (auto sidul : pattern.siduls) {
-        float umin = std::numeric_limits<float>::max();
-        for (auto instance : sidul.second) if (instance->utility < umin) umin = instance->utility;
-        patternUmin += umin;
-    }
-    return patternUmin;
+float computeUmin(const Pattern &pattern) {
+    return sumMinima(pattern.siduls.utility.data(), pattern.siduls.offsets.data(), pattern.siduls.size());
 }
 
-unsigned int computeSE(Pattern pattern, std::unordered_map<unsigned int, Sequence> sequences) {
+unsigned int computeSE(const Pattern &pattern, const Database &database) {
     unsigned int patternSE = 0;
     /*
-        seq.second[0].position+1 is because position starts with 0, not 1
+        position+1 is because position starts with 0, not 1
     */
-    for (auto seq : pattern.siduls) patternSE += (sequences[seq.first].size - (seq.second[0]->position+1) + 1);
+    for (unsigned int idx = 0; idx < pattern.siduls.size(); ++idx)
+        patternSE += (database.sequences[pattern.siduls.sids[idx]].size - (pattern.siduls.position[pattern.siduls.begin(idx)]+1) + 1);
     return patternSE;
 }
 
-unsigned int computeSLIP(Pattern pattern) {
-    unsigned int patternSLIP = 0;
-    for (auto seq : pattern.siduls) patternSLIP += seq.second.size();
-    return patternSLIP;
+unsigned int computeSLIP(const Pattern &pattern) {
+    return countInstances(pattern.siduls.offsets.data(), pattern.siduls.size());
 }
 
-bool isContainedBy(std::string superPatternName, std::string subPatternName) {
-    std::vector<std::string> superPattern, subPattern;
-    boost::split(superPattern, superPatternName, boost::is_any_of(" "));
-    boost::split(subPattern, subPatternName, boost::is_any_of(" "));
-    unsigned int pos = 0;
-    for (auto c : superPattern) if (subPattern.size() > pos && subPattern[pos] == c) ++pos;
-    return pos == subPattern.size();
+/*
+    Each itemset of the sub pattern is matched, in order, against the earliest remaining itemset
+    of the super pattern containing it. Items inside an itemset are sorted in ascending order.
+*/
+bool isContainedBy(const std::pmr::vector<int> &superPattern, const std::pmr::vector<int> &subPattern) {
+    size_t superBegin = 0, subBegin = 0;
+    while (subBegin < subPattern.size()) {
+        size_t subEnd = subBegin;
+        while (subEnd < subPattern.size() && subPattern[subEnd] != END_ITEMSET) ++subEnd;
+        bool isMatched = false;
+        while (!isMatched && superBegin < superPattern.size()) {
+            size_t superEnd = superBegin;
+            while (superEnd < superPattern.size() && superPattern[superEnd] != END_ITEMSET) ++superEnd;
+            size_t superIdx = superBegin, subIdx = subBegin;
+            while (superIdx < superEnd && subIdx < subEnd && superPattern[superIdx] <= subPattern[subIdx]) {
+                if (superPattern[superIdx] == subPattern[subIdx]) ++subIdx;
+                ++superIdx;
+            }
+            isMatched = subIdx == subEnd;
+            superBegin = superEnd + 1;
+        }
+        if (!isMatched) return false;
+        subBegin = subEnd + 1;
+    }
+    return true;
 }
@@ -7,53 +7,122 @@
 #include <sstream>
 #include <iostream>
 #include <numeric>
-#include <boost/algorithm/string.hpp>
+#include <limits>
+#include <algorithm>
 #include "models.h"
+#include "dataset.h"
 
 const std::string SEQUENCES_FILE = "sequences.csv";
 const std::string UTILITIES_FILE = "utilities.csv";
 const int END_ITEMSET = -1;
 const int END_SEQUENCE = -2;
 
-std::unordered_map<unsigned int, std::shared_ptr<Sequence>> readInputData(std::string inputDataPath);
+Database readInputData(std::string inputDataPath);
+/*
+    Also build the SIDULs of all items while loading
+*/
+Database readInputData(std::string inputDataPath, std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems);
 /*
     Utility functions for showing certain objects' information
 */
-void print_sequences(std::unordered_map<int, Sequence> sequences);
+void print_sequences(const Database &database);
 void print_pattern(Pattern pattern);
+std::string pattern_to_string(const std::pmr::vector<int> &items);
 void print_siduls(std::unordered_map<int, Pattern> sidulItems);
 /*
     Utility function for initializing SIDULs of patterns
 */
-std::unordered_map<unsigned int, std::shared_ptr<Pattern>> construct_siduls(std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences);
+std::unordered_map<unsigned int, std::shared_ptr<Pattern>> construct_siduls(const Database &database);
+/*
+    Append the instances of one sequence, whose id is above all ids already in sidulItems
+*/
+void construct_siduls(
+    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    unsigned int seqID,
+    const Sequence &sequence
+);
+/*
+    Add the metrics (umin, RBU, SE, SLIP) of the idx-th sequence of the item's SIDUL to its totals
+*/
+void add_sequence_metrics(Pattern &sidulItem, unsigned int idx, unsigned int sequenceSize);
+/*
+    Add the metrics of the sequences of the pattern's SIDUL from the idx-th one on to its totals,
+    through the kernels of metrics.h, given the number of itemsets of every sequence by id
+*/
+template <typename Utility, typename Position, typename Sid>
+void add_sidul_metrics(BasicPattern<Utility, Position, Sid> &pattern, unsigned int idx, const unsigned int *sequenceSizes);
+/*
+    Join SIDULs built over consecutive ranges of the sequences, e.g. by different threads, given
+    in the order of their ranges. The metrics of the items are summed again in the order of the
+    sequences, so they do not depend on how the sequences were split.
+*/
+void join_siduls(
+    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    std::vector<std::unordered_map<unsigned int, std::shared_ptr<Pattern>>> &fragments,
+    const Database &database
+);
+/*
+    Append a SIDUL built over later sequences, e.g. by another thread, and add up its metrics.
+    sidOffset is added to the sequence ids of the fragment.
+*/
+void merge_siduls(Pattern &sidulItem, const Pattern &fragment, unsigned int sidOffset = 0);
+MiningContext construct_context(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems
+);
+MiningContext construct_context(std::vector<unsigned int> sequenceSizes, std::vector<std::shared_ptr<Pattern>> items);
 /*
     Algorithm for pruning invalid patterns by LRU and Support
 */
-std::unordered_map<unsigned int, std::shared_ptr<Sequence>> WPS_by_LRU_and_Support(
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences,
-    std::unordered_map<unsigned int, std::shared_ptr<Pattern>> sidulItems,
+Database WPS_by_LRU_and_Support(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
     float MIN_SUPP,
     float MIN_UTILITY
 );
+/*
+    WPS_by_LRU_and_Support repeated until no more items are removed, each round lowering the
+    sequence utilities and so the LRU of the items left. The items left are then renumbered
+    0..n-1 in ascending order of support, the items of every itemset being sorted again by
+    their new ids, and originalIds maps the new ids back.
+*/
+Database shrink_database(
+    const Database &database,
+    const std::unordered_map<unsigned int, std::shared_ptr<Pattern>> &sidulItems,
+    float MIN_SUPP,
+    float MIN_UTILITY,
+    std::vector<int> &originalIds
+);
+/*
+    The items of a pattern found over renumbered items, with their original ids and every
+    itemset sorted again
+*/
+std::pmr::vector<int> restore_items(const std::pmr::vector<int> &items, const std::vector<int> &originalIds);
 /*
     Utility functions for extending patterns
     For speeding up, metrics (RBU, umin, SE, SLIP) are computed as well
+    The extended pattern is constructed by the caller, typically in the arena of the search node.
+    Instantiated for the SEARCH_LAYOUTS of models.h.
 */
-std::shared_ptr<Pattern> construct_i_ext(
-    std::shared_ptr<Pattern> pattern,
-    std::shared_ptr<Pattern> item, 
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences
+template <typename Utility, typename Position, typename Sid>
+void construct_i_ext(
+    BasicPattern<Utility, Position, Sid> &extendedPattern,
+    const BasicPattern<Utility, Position, Sid> &pattern,
+    const BasicPattern<Utility, Position, Sid> &item,
+    const BasicMiningContext<Utility, Position, Sid> &context
 );
-std::shared_ptr<Pattern> construct_s_ext(
-    std::shared_ptr<Pattern> pattern,
-    std::shared_ptr<Pattern> item, 
-    std::unordered_map<unsigned int, std::shared_ptr<Sequence>> sequences
+template <typename Utility, typename Position, typename Sid>
+void construct_s_ext(
+    BasicPattern<Utility, Position, Sid> &extendedPattern,
+    const BasicPattern<Utility, Position, Sid> &pattern,
+    const BasicPattern<Utility, Position, Sid> &item,
+    const BasicMiningContext<Utility, Position, Sid> &context
 );
 /*
     Utility functions for computing certain pattern metrics and pattern comparison
 */
-float computeRBU(Pattern pattern);
-float computeUmin(Pattern pattern);
-unsigned int computeSE(Pattern pattern, std::unordered_map<unsigned int, Sequence> sequences);
-unsigned int computeSLIP(Pattern pattern);
-bool isContainedBy(std::string superPatternName, std::string subPatternName);
+float computeRBU(const Pattern &pattern);
+float computeUmin(const Pattern &pattern);
+unsigned int computeSE(const Pattern &pattern, const Database &database);
+unsigned int computeSLIP(const Pattern &pattern);
+bool isContainedBy(const std::pmr::vector<int> &superPattern, const std::pmr::vector<int> &subPattern);